@@ -0,0 +1,390 @@
+/*
+ * herramientas/hal_simulado.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Implementacion de HAL.h para ejecutar el kernel dentro de un proceso del
+ * anfitrion sin senales, temporizadores ni carga de ejecutables. Cada
+ * proceso del minikernel es una pila propia sobre la que se ejecuta su
+ * programa simulado y el codigo del kernel que este invoca; cambio_contexto
+ * solo cambia de pila. Las interrupciones las entrega el generador de
+ * eventos (interrupcion_simulada) y halt, que adelanta el siguiente tick
+ * en vez de esperarlo.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "const.h"
+#include "llamsis.h"
+#include "HAL.h"
+#include "hal_simulado.h"
+
+#undef printf
+
+unsigned long long cambios_contexto_simulados = 0;
+unsigned long long ticks_ociosos_simulados = 0;
+
+static void (*manejadores[NVECTORES])();
+static long registros[NREGS];		/* registros del proceso en ejecucion */
+static int nivel_actual = NIVEL_3;	/* el kernel arranca con las interrupciones prohibidas */
+static int modo_usuario = 0;		/* modo de ejecucion actual */
+static int modo_previo = 0;			/* modo en el que llego la interrupcion en curso */
+static int int_SW_pendiente = 0;
+static char car_terminal = 0;		/* lo que devuelve leer_puerto */
+static int imagenes_vivas = 0;
+static void *pila_pendiente = NULL;	/* pila liberada mientras se usaba */
+
+/* Imagen de un proceso: solo el programa que ejecuta */
+typedef struct
+{
+	programa_simulado *programa;
+} imagen_simulada;
+
+/*
+ * Cambio de pila
+ */
+#if defined(__x86_64__)
+
+/* El puntero de pila guardado se anota donde ucontext guardaria RSP */
+#define PILA_GUARDADA(c) ((c)->ctxt.uc_mcontext.gregs[REG_RSP])
+
+void hal_cambiar_pila(greg_t *guardar, greg_t *cargar) __attribute__((visibility("hidden")));
+void hal_arranque_pila() __attribute__((visibility("hidden")));
+
+/* Como co_cambiar de usuario/lib/corrutinas.c, pero la pila nueva se lee
+   despues de guardar la actual: el kernel puede cambiar de un proceso a si
+   mismo. hal_arranque_pila recibe el programa en r12 y alinea la pila
+   antes de llamar a C */
+__asm__(
+	".text\n"
+	".globl hal_cambiar_pila\n"
+	".hidden hal_cambiar_pila\n"
+	".type hal_cambiar_pila, @function\n"
+	"hal_cambiar_pila:\n"
+	"\tpushq %rbp\n"
+	"\tpushq %rbx\n"
+	"\tpushq %r12\n"
+	"\tpushq %r13\n"
+	"\tpushq %r14\n"
+	"\tpushq %r15\n"
+	"\tmovq %rsp, (%rdi)\n"
+	"\tmovq (%rsi), %rsp\n"
+	"\tpopq %r15\n"
+	"\tpopq %r14\n"
+	"\tpopq %r13\n"
+	"\tpopq %r12\n"
+	"\tpopq %rbx\n"
+	"\tpopq %rbp\n"
+	"\tret\n"
+	".size hal_cambiar_pila, .-hal_cambiar_pila\n"
+	".globl hal_arranque_pila\n"
+	".hidden hal_arranque_pila\n"
+	".type hal_arranque_pila, @function\n"
+	"hal_arranque_pila:\n"
+	"\tmovq %r12, %rdi\n"
+	"\tandq $-16, %rsp\n"
+	"\tcall arrancar_programa\n"
+	"\tud2\n"
+	".size hal_arranque_pila, .-hal_arranque_pila\n");
+
+#endif
+
+void arrancar_programa(imagen_simulada *imagen) __attribute__((used));
+
+static void entregar_int_SW();
+
+/* Libera la pila que se estaba usando al llamar a liberar_pila, una vez
+   que ya se ha cambiado a otra */
+static void liberar_pila_pendiente()
+{
+	if (pila_pendiente != NULL)
+	{
+		munmap(pila_pendiente, *(size_t *)pila_pendiente);
+		pila_pendiente = NULL;
+	}
+}
+
+/* Ejecuta el manejador del vector al nivel que le corresponde, guardando
+   el modo y el nivel previos en la pila del proceso interrumpido */
+static void tratar_vector(int vector, int nivel)
+{
+	int nivel_previo = nivel_actual;
+	int previo = modo_previo;
+
+	modo_previo = modo_usuario;
+	modo_usuario = 0;
+	if (nivel > nivel_actual)
+	{
+		nivel_actual = nivel;
+	}
+
+	manejadores[vector]();
+
+	modo_usuario = modo_previo;
+	modo_previo = previo;
+	nivel_actual = nivel_previo;
+	entregar_int_SW();
+}
+
+static void entregar_int_SW()
+{
+	if (int_SW_pendiente && nivel_actual < NIVEL_1)
+	{
+		int_SW_pendiente = 0;
+		tratar_vector(INT_SW, NIVEL_1);
+	}
+}
+
+void arrancar_programa(imagen_simulada *imagen)
+{
+	liberar_pila_pendiente();
+	nivel_actual = 0;
+	modo_usuario = 1;
+	modo_previo = 0;
+
+	imagen->programa->programa();
+
+	// Como la biblioteca de usuario: al volver de main se termina
+	llamada_simulada(TERMINAR_PROCESO, 0, 0, 0);
+	panico("el proceso simulado sigue tras terminar");
+}
+
+/*
+ * Interfaz con el generador de eventos
+ */
+long llamada_simulada(int nserv, long arg1, long arg2, long arg3)
+{
+	registros[0] = nserv;
+	registros[1] = arg1;
+	registros[2] = arg2;
+	registros[3] = arg3;
+	tratar_vector(LLAM_SIS, nivel_actual);
+	return registros[0];
+}
+
+void interrupcion_simulada(int vector, char car)
+{
+	int nivel = (vector == INT_RELOJ) ? NIVEL_3 : (vector == INT_TERMINAL) ? NIVEL_2 : NIVEL_1;
+
+	if (nivel <= nivel_actual)
+	{
+		return; // Enmascarada: como el HAL, no se guarda
+	}
+	car_terminal = car;
+	tratar_vector(vector, nivel);
+}
+
+/*
+ * Operaciones de HAL.h
+ */
+unsigned long long int leer_reloj_CMOS()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long long)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+void iniciar_cont_reloj(int ticks_por_seg)
+{
+}
+
+void iniciar_cont_teclado()
+{
+}
+
+void iniciar_cont_int()
+{
+}
+
+void instal_man_int(int nvector, void (*manej)())
+{
+	manejadores[nvector] = manej;
+}
+
+int fijar_nivel_int(int nivel)
+{
+	int previo = nivel_actual;
+	nivel_actual = nivel;
+	entregar_int_SW();
+	return previo;
+}
+
+int viene_de_modo_usuario()
+{
+	return modo_previo;
+}
+
+void activar_int_SW()
+{
+	int_SW_pendiente = 1;
+	entregar_int_SW();
+}
+
+void cambio_contexto(contexto_t *contexto_a_salvar, contexto_t *contexto_a_restaurar)
+{
+	// El estado del procesador que no esta en los registros se queda en esta pila
+	int nivel = nivel_actual, modo = modo_usuario, previo = modo_previo;
+
+	cambios_contexto_simulados++;
+	if (contexto_a_salvar != NULL)
+	{
+		memcpy(contexto_a_salvar->registros, registros, sizeof(registros));
+	}
+	memcpy(registros, contexto_a_restaurar->registros, sizeof(registros));
+
+#if defined(__x86_64__)
+	greg_t descartada;
+	hal_cambiar_pila(contexto_a_salvar ? &PILA_GUARDADA(contexto_a_salvar) : &descartada,
+					 &PILA_GUARDADA(contexto_a_restaurar));
+#else
+	if (contexto_a_salvar != NULL)
+	{
+		swapcontext(&(contexto_a_salvar->ctxt), &(contexto_a_restaurar->ctxt));
+	}
+	else
+	{
+		setcontext(&(contexto_a_restaurar->ctxt));
+	}
+#endif
+
+	// Otro proceso ha vuelto a cambiar a este
+	liberar_pila_pendiente();
+	nivel_actual = nivel;
+	modo_usuario = modo;
+	modo_previo = previo;
+}
+
+void *crear_imagen(char *prog, void **dir_ini)
+{
+	for (programa_simulado *p = programas_simulados; p->nombre != NULL; ++p)
+	{
+		if (strcmp(p->nombre, prog) == 0)
+		{
+			imagen_simulada *imagen = malloc(sizeof(imagen_simulada));
+			if (imagen == NULL)
+			{
+				return NULL;
+			}
+			imagen->programa = p;
+			*dir_ini = imagen;
+			imagenes_vivas++;
+			return imagen;
+		}
+	}
+	return NULL;
+}
+
+/* Las pilas se reservan sin respaldo: solo ocupan memoria las paginas que
+   se llegan a usar. La primera palabra guarda el tamanio */
+void *crear_pila(int tam)
+{
+	void *pila = mmap(NULL, tam, PROT_READ | PROT_WRITE,
+					  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (pila == MAP_FAILED)
+	{
+		panico("no se puede reservar la pila de un proceso simulado");
+	}
+	*(size_t *)pila = tam;
+	return pila;
+}
+
+/* La imagen hace de contador de programa: hal_arranque_pila la recibe y
+   ejecuta su programa. Los hilos no se simulan */
+void fijar_contexto_ini(void *mem, void *p_pila, int tam_pila,
+						void *pc_inicial, contexto_t *contexto_ini)
+{
+	memset(contexto_ini->registros, 0, sizeof(contexto_ini->registros));
+	if (pc_inicial != mem)
+	{
+		panico("el simulador no ejecuta hilos");
+	}
+
+#if defined(__x86_64__)
+	void **sp = (void **)(((unsigned long)p_pila + tam_pila) & ~15UL);
+	*--sp = 0;							/* retorno de hal_arranque_pila, que no vuelve */
+	*--sp = (void *)hal_arranque_pila;	/* retorno de hal_cambiar_pila */
+	*--sp = 0;							/* rbp */
+	*--sp = 0;							/* rbx */
+	*--sp = mem;						/* r12 */
+	*--sp = 0;							/* r13 */
+	*--sp = 0;							/* r14 */
+	*--sp = 0;							/* r15 */
+	PILA_GUARDADA(contexto_ini) = (greg_t)sp;
+#else
+	// En 32 bits el puntero cabe en el argumento entero de makecontext
+	getcontext(&(contexto_ini->ctxt));
+	contexto_ini->ctxt.uc_stack.ss_sp = (char *)p_pila + sizeof(size_t);
+	contexto_ini->ctxt.uc_stack.ss_size = tam_pila - sizeof(size_t);
+	contexto_ini->ctxt.uc_link = NULL;
+	makecontext(&(contexto_ini->ctxt), (void (*)())arrancar_programa, 1, (int)mem);
+#endif
+}
+
+void liberar_imagen(void *mem)
+{
+	free(mem);
+	// Como el HAL, el sistema se apaga al liberar la ultima imagen
+	if (--imagenes_vivas == 0)
+	{
+		fin_simulacion();
+		exit(0);
+	}
+}
+
+void liberar_pila(void *pila)
+{
+	liberar_pila_pendiente();
+	pila_pendiente = pila;
+}
+
+long leer_registro(int nreg)
+{
+	return registros[nreg];
+}
+
+int escribir_registro(int nreg, long valor)
+{
+	registros[nreg] = valor;
+	return 0;
+}
+
+char leer_puerto(int dir_puerto)
+{
+	return car_terminal;
+}
+
+/* Sin procesos listos el tiempo no tiene por que pasar: llega el tick siguiente */
+void halt()
+{
+	ticks_ociosos_simulados++;
+	interrupcion_simulada(INT_RELOJ, 0);
+}
+
+void panico(char *mens)
+{
+	fprintf(stderr, "PANICO: %s\n", mens);
+	exit(1);
+}
+
+void escribir_ker(char *buffer, unsigned int longi)
+{
+	fwrite(buffer, 1, longi, stdout);
+}
+
+int printk(const char *formato, ...)
+{
+	va_list args;
+	va_start(args, formato);
+	int n = vprintf(formato, args);
+	va_end(args);
+	return n;
+}
@@ -0,0 +1,45 @@
+/*
+ * herramientas/hal_simulado.h
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Interfaz entre el HAL simulado (hal_simulado.c) y el generador de
+ * eventos del simulador (simulador.c). El HAL simulado implementa HAL.h
+ * sin senales ni imagenes reales: los "programas" de los procesos son
+ * funciones del generador que hacen las llamadas al sistema invocando
+ * directamente el manejador que instala el kernel.
+ */
+
+#ifndef HAL_SIMULADO_H
+#define HAL_SIMULADO_H
+
+/* Programa que puede cargar crear_imagen. La tabla la define el
+   generador y termina con un nombre NULL */
+typedef struct
+{
+	char *nombre;
+	void (*programa)();
+} programa_simulado;
+
+extern programa_simulado programas_simulados[];
+
+/* La llama el HAL al liberar la ultima imagen, cuando el sistema se apaga */
+void fin_simulacion();
+
+/* Desde un proceso simulado: entra en el kernel por LLAM_SIS con el
+   servicio y los argumentos en los registros y devuelve el resultado */
+long llamada_simulada(int nserv, long arg1, long arg2, long arg3);
+
+/* Entrega una interrupcion (INT_RELOJ, INT_TERMINAL...) al nivel que le
+   corresponde, como si acabara de llegar. En INT_TERMINAL el puerto
+   devuelve "car" */
+void interrupcion_simulada(int vector, char car);
+
+/* Contadores del HAL simulado */
+extern unsigned long long cambios_contexto_simulados;
+extern unsigned long long ticks_ociosos_simulados;	/* ticks entregados desde halt */
+
+#endif /* HAL_SIMULADO_H */
@@ -0,0 +1,193 @@
+/*
+ * herramientas/inyector.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa del anfitrion que ejecuta el minikernel en un pseudoterminal y
+ * escribe caracteres en su entrada con un ritmo fijo, para medir el
+ * tratamiento del terminal sin teclear. La salida del minikernel se copia
+ * a la salida estandar.
+ *
+ * Uso (desde boot/, como el arranque normal):
+ *	../herramientas/inyector [opciones] ./boot ../minikernel/kernel
+ *
+ *	-r N	caracteres (o rafagas) por segundo. Por defecto 100
+ *	-b N	caracteres de cada rafaga, escritos de una vez. Por defecto 1,
+ *		como mucho MAX_RAFAGA
+ *	-n N	caracteres que se envian. Por defecto 1000, o todo el fichero con -f
+ *	-f F	envia el contenido del fichero F en vez de "abc...z" ciclico. Con
+ *		-n se envia como mucho su longitud
+ *	-e MS	espera inicial antes de empezar, para el arranque. Por defecto 1000
+ *
+ * Al terminar el minikernel escribe en la salida de error
+ *	INYECTOR enviados=N ms=N
+ * Los caracteres recibidos, perdidos y leidos los cuenta el kernel (ver
+ * usuario/lector_terminal.c y el volcado al apagarse). El HAL trata un
+ * caracter por interrupcion, por lo que los que llegan juntos se pierden
+ * antes de int_terminal: la diferencia entre enviados y recibidos mide
+ * esas perdidas del dispositivo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#define TAM_SALIDA 4096
+#define MAX_RAFAGA 4096
+
+static long long ahora_us()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static void uso(char *programa)
+{
+	fprintf(stderr, "uso: %s [-r por_seg] [-b rafaga] [-n total] [-f fichero] [-e espera_ms] programa [args]\n", programa);
+	exit(1);
+}
+
+// Carga el fichero entero en memoria. Devuelve su longitud
+static long cargar_fichero(char *nombre, char **datos)
+{
+	FILE *f = fopen(nombre, "rb");
+	if (f == NULL)
+	{
+		perror(nombre);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	long longitud = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	*datos = malloc(longitud > 0 ? longitud : 1);
+	if (*datos == NULL || fread(*datos, 1, longitud, f) != (size_t)longitud)
+	{
+		fprintf(stderr, "error leyendo %s\n", nombre);
+		exit(1);
+	}
+	fclose(f);
+	return longitud;
+}
+
+// Copia a la salida estandar lo que haya escrito el minikernel, esperando
+// como mucho "espera_ms". Devuelve 0 cuando el minikernel ha cerrado el terminal
+static int copiar_salida(int maestro, int espera_ms)
+{
+	struct pollfd pfd = { maestro, POLLIN, 0 };
+	char salida[TAM_SALIDA];
+
+	if (poll(&pfd, 1, espera_ms) <= 0)
+	{
+		return 1;
+	}
+	ssize_t leidos = read(maestro, salida, sizeof(salida));
+	if (leidos <= 0)
+	{
+		return 0; // EIO: ya no queda nadie en el otro extremo
+	}
+	fwrite(salida, 1, leidos, stdout);
+	fflush(stdout);
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int por_seg = 100, rafaga = 1, espera_ms = 1000;
+	long total = 1000;
+	int total_fijado = 0;
+	char *datos = NULL;
+	long longitud_datos = 0;
+	int opcion;
+
+	while ((opcion = getopt(argc, argv, "+r:b:n:f:e:")) != -1)
+	{
+		switch (opcion)
+		{
+		case 'r': por_seg = atoi(optarg); break;
+		case 'b': rafaga = atoi(optarg); break;
+		case 'n': total = atol(optarg); total_fijado = 1; break;
+		case 'f': longitud_datos = cargar_fichero(optarg, &datos); break;
+		case 'e': espera_ms = atoi(optarg); break;
+		default: uso(argv[0]);
+		}
+	}
+	if (optind >= argc || por_seg <= 0 || rafaga <= 0 || rafaga > MAX_RAFAGA || total < 0)
+	{
+		uso(argv[0]);
+	}
+	// Los caracteres se sacan del fichero: no se puede enviar mas de lo que tiene
+	if (datos != NULL && (!total_fijado || total > longitud_datos))
+	{
+		total = longitud_datos;
+	}
+
+	// Sin modo canonico ni eco: cada caracter llega al minikernel al escribirlo
+	struct termios modo;
+	memset(&modo, 0, sizeof(modo));
+	cfmakeraw(&modo);
+
+	int maestro;
+	pid_t hijo = forkpty(&maestro, NULL, &modo, NULL);
+	if (hijo < 0)
+	{
+		perror("forkpty");
+		return 1;
+	}
+	if (hijo == 0)
+	{
+		execvp(argv[optind], &argv[optind]);
+		perror(argv[optind]);
+		_exit(127);
+	}
+
+	long long fin_espera = ahora_us() + (long long)espera_ms * 1000;
+	int vivo = 1;
+	while (vivo && ahora_us() < fin_espera)
+	{
+		vivo = copiar_salida(maestro, 10);
+	}
+
+	// Cada rafaga sale en su instante teorico, sin acumular el retraso de las anteriores
+	long enviados = 0;
+	long long inicio = ahora_us();
+	for (long n = 0; vivo && enviados < total; n++)
+	{
+		long long instante = inicio + n * 1000000LL / por_seg;
+		long long falta;
+		while (vivo && (falta = instante - ahora_us()) > 0)
+		{
+			vivo = copiar_salida(maestro, (int)((falta + 999) / 1000));
+		}
+
+		char buffer[MAX_RAFAGA];
+		int num = (total - enviados < rafaga) ? (int)(total - enviados) : rafaga;
+		for (int i = 0; i != num; ++i)
+		{
+			buffer[i] = (datos != NULL) ? datos[enviados + i] : 'a' + (enviados + i) % 26;
+		}
+		if (vivo && write(maestro, buffer, num) == num)
+		{
+			enviados += num;
+		}
+	}
+	long long duracion = ahora_us() - inicio;
+
+	while (vivo)
+	{
+		vivo = copiar_salida(maestro, -1);
+	}
+	waitpid(hijo, NULL, 0);
+
+	fprintf(stderr, "INYECTOR enviados=%ld ms=%lld\n", enviados, duracion / 1000);
+	return 0;
+}
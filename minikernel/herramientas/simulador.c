@@ -0,0 +1,284 @@
+/*
+ * herramientas/simulador.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Simulador para medir el coste del kernel sin el HAL real. Enlaza
+ * minikernel/kernel.c con hal_simulado.c y hace de generador de eventos:
+ * los procesos ejecutan un escenario de llamadas al sistema fijado de
+ * antemano y el reloj da un tick cada cierto numero de llamadas. Como no
+ * hay senales ni codigo de usuario real, el tiempo medido es el del kernel
+ * (colas, planificador, mutex...) mas el cambio de pila del HAL simulado.
+ *
+ * Uso (desde herramientas/):
+ *	./simulador [-e escenario] [-p procesos] [-n llamadas] [-t llamadas_por_tick]
+ *
+ *	-e	nula (obtener_id_pr), ceder (ceder_cpu), dormir (dormir_ticks(1)),
+ *		mutex (lock, ceder_cpu, unlock sobre NUM_MUTEX mutex) o mixto.
+ *		Por defecto mixto
+ *	-p	procesos que ejecutan el escenario. Por defecto MAX_PROC - 1
+ *	-n	llamadas al sistema que se miden. Por defecto 1000000
+ *	-t	llamadas al sistema entre dos ticks. Por defecto 1000
+ *
+ * Al terminar escribe, despues de los volcados del kernel,
+ *	SIMULADOR escenario=E procesos=N llamadas=N ns=N llamadas_por_seg=N
+ *	ns_por_llamada=N cambios=N ticks=N ticks_ociosos=N arranque_ns=N
+ *	terminacion_ns=N
+ * donde arranque_ns es lo que tarda init en crear los procesos y
+ * terminacion_ns lo que tardan en terminar todos tras la medida. Para
+ * simular mas procesos compile con "make clean; make MAX_PROC=100000".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "const.h"
+#include "llamsis.h"
+#include "hal_simulado.h"
+
+#define NO_RECURSIVO 1	/* debe coincidir con usuario/include/servicios.h */
+#define NUM_MUTEX 4		/* mutex que comparten los procesos del escenario mutex */
+
+int main_kernel();		/* main de minikernel/kernel.c */
+
+/* Estado de cada proceso simulado. Va en su pila */
+typedef struct
+{
+	int vuelta;
+	int mutex;
+} trabajador;
+
+typedef struct
+{
+	char *nombre;
+	void (*operacion)(trabajador *);	/* una vuelta del proceso */
+	int usa_mutex;
+} escenario;
+
+static escenario *esc;
+static int procesos;
+static unsigned long long objetivo = 1000000;
+static int llamadas_por_tick = 1000;
+
+/* Medida: la ventana va desde que init termina de crear los procesos
+   hasta que se han hecho "objetivo" llamadas */
+static unsigned long long llamadas = 0, llamadas_inicio = 0, llamadas_fin = 0;
+static unsigned long long ticks = 0, ticks_inicio = 0, ticks_fin = 0;
+static unsigned long long ociosos_inicio = 0, ociosos_fin = 0;
+static unsigned long long cambios_inicio = 0, cambios_fin = 0;
+static unsigned long long ns_creacion = 0, ns_inicio = 0, ns_fin = 0;
+static int creados = 0, arrancar = 0, parar = 0;
+static char *nombre_salida = "salida";	/* mutex que retiene a los procesos hasta empezar */
+static int contador_tick = 0;
+
+static unsigned long long ahora_ns()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long long)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+/* Llamada al sistema de un proceso simulado. Tras ella llega el tick si toca */
+static long llamar(int nserv, long arg1, long arg2)
+{
+	long res = llamada_simulada(nserv, arg1, arg2, 0);
+
+	llamadas++;
+	if (++contador_tick == llamadas_por_tick)
+	{
+		contador_tick = 0;
+		ticks++;
+		interrupcion_simulada(INT_RELOJ, 0);
+	}
+	if (arrancar && !parar && llamadas - llamadas_inicio >= objetivo)
+	{
+		ns_fin = ahora_ns();
+		parar = 1;
+		llamadas_fin = llamadas;
+		ticks_fin = ticks;
+		ociosos_fin = ticks_ociosos_simulados;
+		cambios_fin = cambios_contexto_simulados;
+	}
+	return res;
+}
+
+/*
+ * Escenarios
+ */
+static void op_nula(trabajador *t)
+{
+	llamar(OBTENER_ID, 0, 0);
+}
+
+static void op_ceder(trabajador *t)
+{
+	llamar(CEDER_CPU, 0, 0);
+}
+
+static void op_dormir(trabajador *t)
+{
+	llamar(DORMIR_TICKS, 1, 0);
+}
+
+/* Se cede el procesador con el mutex tomado para que los demas se bloqueen en lock */
+static void op_mutex(trabajador *t)
+{
+	llamar(LOCK_MUTEX, t->mutex, 0);
+	llamar(CEDER_CPU, 0, 0);
+	llamar(UNLOCK_MUTEX, t->mutex, 0);
+}
+
+/* De cada 16 vueltas: una duerme, cuatro toman el mutex, dos ceden y el resto son nulas */
+static void op_mixto(trabajador *t)
+{
+	switch (t->vuelta % 16)
+	{
+	case 0:
+		op_dormir(t);
+		break;
+	case 1:
+	case 5:
+	case 9:
+	case 13:
+		llamar(LOCK_MUTEX, t->mutex, 0);
+		llamar(UNLOCK_MUTEX, t->mutex, 0);
+		break;
+	case 3:
+	case 11:
+		op_ceder(t);
+		break;
+	default:
+		op_nula(t);
+	}
+}
+
+static escenario escenarios[] = {
+	{ "nula", op_nula, 0 },
+	{ "ceder", op_ceder, 0 },
+	{ "dormir", op_dormir, 0 },
+	{ "mutex", op_mutex, 1 },
+	{ "mixto", op_mixto, 1 },
+	{ NULL, NULL, 0 }
+};
+
+/*
+ * Programas
+ */
+
+/* El primero que llega crea el mutex. Si ya existe, se abre */
+static int mutex_compartido(int n)
+{
+	char nombre[8];
+	int m;
+
+	snprintf(nombre, sizeof(nombre), "sim%d", n % NUM_MUTEX);
+	if ((m = llamar(CREAR_MUTEX, (long)nombre, NO_RECURSIVO)) < 0)
+	{
+		m = llamar(ABRIR_MUTEX, (long)nombre, 0);
+	}
+	return m;
+}
+
+static void programa_trabajador()
+{
+	trabajador t;
+
+	t.vuelta = 0;
+	t.mutex = esc->usa_mutex ? mutex_compartido(llamar(OBTENER_ID, 0, 0)) : -1;
+
+	// Esperar bloqueados en el mutex de salida y no en la cola de listos, que
+	// haria de init un proceso mas mientras crea a los demas
+	int salida = llamar(ABRIR_MUTEX, (long)nombre_salida, 0);
+	llamar(LOCK_MUTEX, salida, 0);
+	llamar(UNLOCK_MUTEX, salida, 0);
+	llamar(CERRAR_MUTEX, salida, 0);
+
+	while (!parar)
+	{
+		esc->operacion(&t);
+		t.vuelta++;
+	}
+}
+
+static void programa_init()
+{
+	unsigned long long inicio = ahora_ns();
+	int salida = llamar(CREAR_MUTEX, (long)nombre_salida, NO_RECURSIVO);
+
+	llamar(LOCK_MUTEX, salida, 0);
+	for (creados = 0; creados < procesos; creados++)
+	{
+		if (llamar(CREAR_PROCESO, (long)"trabajador", 0) < 0)
+		{
+			break;
+		}
+	}
+	ns_inicio = ahora_ns();
+	ns_creacion = ns_inicio - inicio;
+	llamadas_inicio = llamadas;
+	ticks_inicio = ticks;
+	ociosos_inicio = ticks_ociosos_simulados;
+	cambios_inicio = cambios_contexto_simulados;
+	arrancar = 1;
+	llamar(UNLOCK_MUTEX, salida, 0);
+}
+
+programa_simulado programas_simulados[] = {
+	{ "init", programa_init },
+	{ "trabajador", programa_trabajador },
+	{ NULL, NULL }
+};
+
+void fin_simulacion()
+{
+	unsigned long long ns = ns_fin - ns_inicio;
+	unsigned long long n = llamadas_fin - llamadas_inicio;
+
+	printf("SIMULADOR escenario=%s procesos=%d llamadas=%llu ns=%llu llamadas_por_seg=%llu "
+		   "ns_por_llamada=%llu cambios=%llu ticks=%llu ticks_ociosos=%llu arranque_ns=%llu "
+		   "terminacion_ns=%llu\n",
+		   esc->nombre, creados, n, ns, (ns > 0) ? n * 1000000000ULL / ns : 0ULL,
+		   (n > 0) ? ns / n : 0ULL, cambios_fin - cambios_inicio,
+		   (ticks_fin - ticks_inicio) + (ociosos_fin - ociosos_inicio), ociosos_fin - ociosos_inicio,
+		   ns_creacion, ahora_ns() - ns_fin);
+	fflush(stdout);
+}
+
+static void uso(char *programa)
+{
+	fprintf(stderr, "uso: %s [-e nula|ceder|dormir|mutex|mixto] [-p procesos] [-n llamadas] [-t llamadas_por_tick]\n", programa);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	char *nombre = "mixto";
+	int opcion;
+
+	procesos = MAX_PROC - 1;
+	while ((opcion = getopt(argc, argv, "e:p:n:t:")) != -1)
+	{
+		switch (opcion)
+		{
+		case 'e': nombre = optarg; break;
+		case 'p': procesos = atoi(optarg); break;
+		case 'n': objetivo = strtoull(optarg, NULL, 10); break;
+		case 't': llamadas_por_tick = atoi(optarg); break;
+		default: uso(argv[0]);
+		}
+	}
+	for (esc = escenarios; esc->nombre != NULL && strcmp(esc->nombre, nombre) != 0; ++esc)
+		;
+	if (esc->nombre == NULL || procesos < 1 || procesos >= MAX_PROC || objetivo == 0 || llamadas_por_tick < 1)
+	{
+		uso(argv[0]);
+	}
+
+	return main_kernel(); // No vuelve: termina al liberar la ultima imagen
+}
@@ -22,7 +22,10 @@
 #define NULL (void *) 0		/* por si acaso no esta ya definida */
 #endif
 
-#define MAX_PROC 10		/* dimension de tabla de procesos */
+#ifndef MAX_PROC
+#define MAX_PROC 10		/* dimension de tabla de procesos. Se puede fijar
+				   al compilar para pruebas de escala */
+#endif
 
 #define TAM_PILA 32768
 
@@ -68,11 +71,60 @@
 #define TICKS_POR_RODAJA 3// 10
 
 /* constantes usada en implementacion de mutex */
-#define NUM_MUT 16 /* numero total de mutex en el sistema */
-#define NUM_MUT_PROC 4 /* numero maximo de mutex que puede tener
-			  abiertos un proceso */
+#define NUM_MUT 16 /* numero de mutex de cada bloque de la tabla de mutex,
+		     que crece por bloques a medida que hacen falta */
+#ifndef MAX_MUT
+#define MAX_MUT 256 /* numero maximo de mutex en el sistema (multiplo
+		       de NUM_MUT). Se puede fijar al compilar */
+#endif
+#define NUM_MUT_PROC 4 /* numero de descriptores de mutex incluidos en
+			  el BCP */
+#define MAX_MUT_PROC 64 /* numero maximo de mutex que puede tener
+			   abiertos un proceso. Los que exceden de
+			   NUM_MUT_PROC se reservan dinamicamente */
 #define MAX_NOM_MUT 8 /* longitud maxima de un nombre de mutex */
 
+/* constantes usadas en implementacion de colas de mensajes */
+#define NUM_COLAS 16 /* numero total de colas de mensajes en el sistema */
+#define MAX_NOM_COLA 8 /* longitud maxima de un nombre de cola */
+#define MAX_MENSAJES_COLA 32 /* capacidad maxima de una cola */
+
+/* constantes usadas en implementacion de memoria compartida */
+#define TAM_PAGINA 4096 /* tamaño de pagina del asignador de memoria compartida */
+#define NUM_PAGINAS_COMPARTIDAS 256 /* paginas de la zona de memoria compartida */
+#define NUM_SEGMENTOS 16 /* numero total de segmentos de memoria compartida */
+#define MAX_NOM_SEG 8 /* longitud maxima de un nombre de segmento */
+
+/* constante usada en implementacion de temporizadores periodicos */
+#define NUM_TEMPORIZADORES 16 /* numero total de temporizadores del sistema */
+
+/* constante usada en implementacion de planificacion de tiempo real */
+#define UTILIZACION_MAX_TIEMPO_REAL 900 /* suma maxima de presupuesto/periodo
+				 de las tareas de tiempo real, en milesimas */
+
+/* constantes usadas en implementacion de grupos con cuota de procesador */
+#define NUM_GRUPOS 8 /* numero de grupos. El 0 es el de los procesos iniciales */
+#define VENTANA_CUOTA 100 /* ticks de cada ventana en la que se contabilizan las cuotas */
+
+/* constante usada en el perfil de contencion de mutex */
+#define NUM_CUBETAS_HISTOGRAMA 40 /* cubetas de los histogramas log2 de
+				 tiempos de espera y retencion, en ciclos */
+
+/* constantes usadas en la traza de eventos del kernel */
+#define TAM_TRAZA 4096 /* eventos del buffer circular de traza (potencia de 2) */
+#define MASCARA_TRAZA_INICIAL 0 /* categorias activas al arrancar si no se
+				 fija la variable de entorno MINIKERNEL_TRAZA */
+
+/* constante usada en el muestreo del contador de programa */
+#define NUM_MUESTRAS 512 /* muestras que guarda cada proceso */
+
+/* constante usada en el reloj de alta resolucion */
+#define MS_CALIBRACION 20 /* milisegundos del reloj CMOS con los que se
+				 calibra el contador de ciclos al arrancar */
+
+/* constante usada en las latencias de planificacion */
+#define TAM_HISTORIAL_LISTOS 1024 /* ticks de los que se guarda la longitud de la cola de listos */
+
 /* constante usada en implementacion de manejador de terminal */
 #define TAM_BUF_TERM 8 /* tama�o del buffer del terminal */
 
@@ -11,6 +11,8 @@
 #include "const.h"
 #include "HAL.h"
 #include "llamsis.h"
+#include <signal.h>
+#include <stdio.h>
 
 /**
  * Constantes
@@ -21,15 +23,91 @@
 #define MUTEX_ESTADO_CREADO 1
 // #define MUTEX_ESTADO_ABIERTO 2
 #define MUTEX_ESTADO_BLOQUEADO 2
+#define MUTEX_POLITICA_FIFO 0			// Al hacer unlock se cede el mutex directamente al primer proceso bloqueado
+#define MUTEX_POLITICA_COMPETITIVA 1	// Al hacer unlock se despierta al proceso bloqueado, que compite de nuevo por el mutex
+#define BUFFER_MARCA 0x4d534a45		// Marca de las cabeceras de buffers de mensaje validos
+#define ZOMBI 4							// Estado del lider de un proceso que ha terminado mientras quedan otros hilos
+
+// Colas del sistema en las que puede estar un proceso, segun obtener_instantanea
+#define COLA_LISTOS 0
+#define COLA_DORMIR 1
+#define COLA_MUTEX_LIBRE 2
+#define COLA_MUTEX_LOCK 3
+#define COLA_TERMINAL 4
+#define COLA_PLAZO 5
+#define COLA_TIEMPO_REAL_AGOTADOS 6
+#define COLA_GRUPOS_APARCADOS 7
+#define COLA_OTRA 8						// Colas de mensajes. No se cuenta su longitud
+#define NUM_COLAS_SISTEMA 8
+
+// Tipos de evento de la traza
+#define TRAZA_CAMBIO_CONTEXTO 0			// dato1: proceso saliente, dato2: proceso entrante
+#define TRAZA_ENTRADA_LLAMADA 1			// dato1: numero de servicio
+#define TRAZA_SALIDA_LLAMADA 2			// dato1: numero de servicio, dato2: resultado
+#define TRAZA_BLOQUEO 3					// dato1: COLA_* en la que se bloquea
+#define TRAZA_DESPERTAR 4				// dato1: proceso que pasa a listo
+#define TRAZA_INTERRUPCION 5			// dato1: vector (INT_RELOJ | INT_TERMINAL | INT_SW)
+
+// Categorias de la mascara de traza
+#define TRAZA_PLANIFICACION 0x1
+#define TRAZA_LLAMADAS 0x2
+#define TRAZA_ESPERAS 0x4
+#define TRAZA_INTERRUPCIONES 0x8
+#define TRAZA_TODAS 0xf
+
+// Motivos por los que un proceso pasa a la cola de listos, para las latencias de planificacion
+#define CAUSA_NUEVO 0					// Proceso o hilo recien creado
+#define CAUSA_DORMIR 1					// Vence dormir() o sus variantes
+#define CAUSA_TERMINAL 2				// Llega un caracter del terminal
+#define CAUSA_MUTEX 3					// unlock cede o libera el mutex, o queda un mutex libre para crear
+#define CAUSA_PLAZO 4					// Vence una espera limitada
+#define CAUSA_TIEMPO_REAL 5				// Empieza el periodo de una tarea de tiempo real sin presupuesto
+#define CAUSA_CUOTA 6					// Empieza una ventana y el grupo recupera su cuota
+#define CAUSA_EXPULSION 7				// Fin de rodaja, expulsion por una tarea de tiempo real o ceder_cpu
+#define CAUSA_OTRA 8					// Colas de mensajes
+#define NUM_CAUSAS_LISTO 9
+
+// Grabacion y reproduccion de las interrupciones externas (variables de entorno
+// MINIKERNEL_GRABAR y MINIKERNEL_REPRODUCIR). La posicion de cada evento es el
+// numero de llamadas al sistema iniciadas cuando llego
+#define EVENTOS_NORMAL 0
+#define EVENTOS_GRABAR 1
+#define EVENTOS_REPRODUCIR 2		// Se ignoran el reloj y el terminal reales salvo para reproducir los ticks grabados
+#define EXTERNO_RELOJ 0
+#define EXTERNO_TERMINAL 1			// dato: caracter
+
+// Nivel de los mensajes de diagnostico del kernel. Con 0 no se compilan: el
+// compilador descarta el printk pero sigue comprobando sus argumentos
+#ifndef DEPURACION
+#define DEPURACION 1
+#endif
+#define DEPURAR(...) do { if (DEPURACION > 0) printk(__VA_ARGS__); } while (0)
+
+// Medicion de la duracion de cada llamada al sistema en tratar_llamsis
+#ifndef PERFIL_LLAMADAS
+#define PERFIL_LLAMADAS 1
+#endif
+#define PERFIL_SISTEMA -2				// Id con el que obtener_perfil_llamada devuelve el perfil de todos los procesos
+
+// Anota un evento en la traza si su categoria esta activa. Sin coste de llamada si no lo esta
+#define TRAZAR(categoria, tipo, dato1, dato2) do { if (mascara_traza & (categoria)) trazar((tipo), (dato1), (dato2)); } while (0)
 
 /**
  * Declaracion de tipos
  */
 typedef struct BCP_t BCP;
 typedef struct mutex_t mutex;
+typedef struct perfil_llamada_t perfil_llamada;
 typedef struct servicio_t servicio;
 typedef struct lista_t lista_BCPs;
 typedef struct terminal_t terminal;
+typedef struct mensaje_t mensaje;
+typedef struct cola_mensajes_t cola_mensajes;
+typedef struct buffer_mensaje_t buffer_mensaje;
+typedef struct segmento_t segmento;
+typedef struct temporizador_t temporizador;
+typedef struct grupo_t grupo;
+typedef struct estadisticas_proceso_t estadisticas_proceso;
 /**
  * Declaracion de funciones
  */
@@ -37,9 +115,15 @@ typedef struct terminal_t terminal;
 static void iniciar_tabla_proc();	// Inicia la tabla de procesos
 static int buscar_BCP_libre();		// Busca una entrada libre en la tabla de procesos
 static int crear_tarea(char *programa);		// Crea un proceso reservando sus recursos. Usada por la llamada al sistema "crear_proceso"
+static int crear_hilo(void *inicio, void *funcion, void *arg);	// Crea un hilo que comparte la imagen y los descriptores del proceso actual
 
 // Operaciones sobre las listas. Primero eliminar un proceso. Despues eliminarlo
 static void insertar_ultimo(lista_BCPs *lista, BCP *proceso);	// Insertar un BCP al final de la lista
+static void insertar_primero(lista_BCPs *lista, BCP *proceso);	// Insertar un BCP al principio de la lista
+static void insertar_listo(BCP *proceso, int causa);			// Pasa un proceso a la cola de listos, o lo aparca si su grupo no tiene cuota. causa: CAUSA_*
+static void marcar_listo(BCP *proceso, int causa);				// Anota cuando y por que pasa a listo, para medir la latencia hasta que ejecute
+static void anotar_despacho(BCP *proceso);						// Suma la latencia del proceso elegido por el planificador
+static void anotar_longitud_listos();							// Guarda la longitud de la cola de listos en cada tick
 static void eliminar_primero(lista_BCPs *lista);				// Elimina el primer BCP de la lista
 static void eliminar_elem(lista_BCPs *lista, BCP *proceso);		// Elimina el BCP "proceso" de la lista
 
@@ -48,29 +132,109 @@ static void exc_arit();		// Tratamiento de excepciones de acceso a memoria
 static void exc_mem();		// Tratamiento de excepciones aritmeticas
 
 // Vinculadas a las RTI y planificacion
-static BCP* planificador();		// Funcion de planificacion mediante un algoritmo FIFO
+static BCP* planificador();		// Funcion de planificacion: EDF para las tareas de tiempo real y FIFO para el resto
+static BCP* elegir_tiempo_real();	// Tarea de tiempo real lista con el plazo mas cercano. NULL si no hay
+static void nuevo_periodo(BCP *proceso);	// Comienza un periodo de una tarea de tiempo real, contando el plazo si se perdio
+static void salir_tiempo_real(BCP *proceso);	// Devuelve una tarea de tiempo real a la clase normal y libera su utilizacion
+
+// Grupos con cuota de procesador
+static void iniciar_grupos();
+static int grupo_agotado(int id_grupo);		// Indica si el grupo ha consumido su cuota en la ventana actual
+static void aparcar_grupo(int id_grupo);	// Saca de la cola de listos los procesos del grupo salvo el actual
+static void nueva_ventana();				// Reinicia las cuotas y devuelve a la cola de listos los procesos aparcados
 static void liberar_proceso();  // Funcion auxiliar que termina proceso actual liberando sus recursos.
  									// Usada por la llamada "terminar_proceso" y por rutinas que tratan excepciones
 static void espera_int();		// Espera a que se produzca una interrupcion
 static void int_reloj();		// Tratamiento de interrupciones de reloj
 static void int_sw();			// Tratamiento de interrupciones software
 static void int_terminal();		// Tratamiento de interrupciones de terminal
+static void tratar_tick();			// Trabajo de cada tick de reloj, real o reproducido
+static void recibir_caracter(char car);	// Mete un caracter en el buffer del terminal y despierta a los que lo esperan
+static void contabilizar(BCP *proceso, int en_ejecucion);	// Carga los ticks de la situacion anterior del proceso y empieza a contar la actual
+static void cargar_ticks(BCP *proceso);		// Carga los ticks pendientes sin cambiar de situacion
+static void bloquear(lista_BCPs *cola, int ciclos_plazo);	// Bloquea el proceso actual en "cola". Si ciclos_plazo >= 0 la espera vence tras ese numero de ciclos
+static void vencer_plazo(BCP *proceso);						// Despierta a un proceso cuya espera limitada ha vencido
+static void quitar_plazo(BCP *proceso);						// Saca de la lista de plazos a un proceso que despierta antes de que venza su espera
+static int identificar_cola(lista_BCPs *cola);				// Codigo COLA_* de una cola de espera
+static void dormir_hasta(int tick);							// Bloquea el proceso actual hasta el tick absoluto "tick"
+
+// Temporizadores periodicos
+static void iniciar_temporizadores();
+static temporizador* obtener_temporizador(unsigned int id_temp);	// Devuelve un temporizador del proceso actual. NULL si no lo es
+static void liberar_temporizadores();							// Libera los temporizadores del proceso actual
 
 // Vinculadas a los mutex
 static void iniciar_tabla_mutex();
-static int buscar_descriptor_libre();
+static int ampliar_tabla_mutex();		// Anade un bloque de NUM_MUT mutex a la tabla de mutex
+static mutex* obtener_mutex(int mutex_id);	// Devuelve el mutex con el id argumento
+static mutex* obtener_descriptor(BCP *proceso, unsigned int descriptor);	// Devuelve el mutex de un descriptor. NULL si no existe
+static void fijar_descriptor(BCP *proceso, unsigned int descriptor, mutex *mut);
+static int buscar_descriptor_libre();	// Busca un descriptor libre del proceso actual, ampliando su tabla si es necesario
 static int buscar_nombre_mutex(char *nombre_mutex);
 static int buscar_mutex_libre();
+static int adquirir_mutex(unsigned int descriptor, int ciclos_plazo);	// Lock comun. ciclos_plazo: -1 espera indefinida, 0 no espera, > 0 espera limitada
+static int adquirir_mutex_sin_int(unsigned int descriptor, int ciclos_plazo);	// adquirir_mutex ya en NIVEL_3
 static BCP* buscar_procesos_con_mutex(mutex *mutex);	// Busca entre la lista de procesos bloqueados debidos a lock
 														// un proceso que haya abierto el mutex argumento
+static int usado_por_otro_hilo(mutex *mut);	// Indica si otro hilo del proceso actual posee el mutex o espera por el
 static void unlock(int descriptor, mutex *mutex_unlock);
-static void cerrar(int descriptor, mutex *mutex_cerrar);
+static void cerrar(int descriptor, mutex *mutex_cerrar);	// Cierra un descriptor. El mutex se elimina al cerrarse su ultimo descriptor
+static void despertar_creador_mutex();	// Desbloquea a un proceso que espera por un mutex libre en "crear_mutex"
+static unsigned long long leer_ciclos();	// Contador de ciclos del procesador, para medir esperas y retenciones
+static int cubeta_histograma(unsigned long long ciclos);	// Cubeta log2 de un tiempo en los histogramas del perfil
+static void anotar_adquisicion(mutex *mut, BCP *proceso);	// Perfil: "proceso" pasa a poseer "mut". Cuenta su espera si se bloqueo
+static void anotar_liberacion(mutex *mut);	// Perfil: el propietario suelta "mut". Cuenta el tiempo de retencion
+static void volcar_perfil_mutex();			// Muestra el perfil de todos los mutex usados. Se llama al quedar el sistema sin procesos
+
+// Perfil de llamadas al sistema
+static void sumar_llamada(perfil_llamada *perfil, unsigned long long ciclos);
+static void anotar_llamada(int servicio, unsigned long long ciclos);	// Suma una llamada al perfil del sistema y al del proceso actual
+static void volcar_perfil_llamadas();	// Muestra el perfil de los servicios usados. Se llama al quedar el sistema sin procesos
+
+// Traza de eventos
+static void iniciar_traza();	// Fija la mascara inicial segun la variable de entorno MINIKERNEL_TRAZA
+static void trazar(int tipo, int dato1, int dato2);	// Anota un evento en el buffer circular. Usar a traves de TRAZAR
+
+// Muestreo del contador de programa
+static void iniciar_muestreo();	// Intercala capturar_pc en el manejador de la senal de reloj del HAL
+static void capturar_pc(int senal, siginfo_t *info, void *contexto);	// Guarda el contador de programa interrumpido y llama al manejador del HAL
+static void tomar_muestra();	// Anota pc_interrumpido en las muestras del proceso actual. Llamada desde int_reloj
+
+// Reloj de alta resolucion
+static void calibrar_reloj();	// Mide los ciclos por milisegundo del reloj CMOS. Espera MS_CALIBRACION ms
+static unsigned long long ns_desde_arranque();	// Nanosegundos desde calibrar_reloj segun el contador de ciclos
+static void iniciar_pagina_tiempo();	// Crea la pagina de tiempo con una vista de escritura para el kernel y otra de solo lectura
+
+// Colas de mensajes
+static void iniciar_tabla_colas();
+static int buscar_nombre_cola(char *nombre_cola);
+static cola_mensajes* obtener_cola(unsigned int id_cola);	// Devuelve la cola con el id argumento. NULL si no existe
+static buffer_mensaje* obtener_buffer(void *dir);			// Devuelve la cabecera de un buffer del proceso actual. NULL si no lo es
+static void liberar_buffers();								// Libera los buffers de mensaje del proceso actual
+static BCP* despertar_primero(lista_BCPs *lista);			// Desbloquea al primer proceso de una lista de bloqueados
+
+// Memoria compartida
+static void iniciar_memoria_compartida();
+static int reservar_paginas(int num_paginas);				// Asigna num_paginas contiguas. Devuelve la primera o -1
+static void liberar_paginas(int primera, int num_paginas);
+static int buscar_nombre_segmento(char *nombre_segmento);
+static int buscar_segmento_dir(void *dir);					// Devuelve el segmento que comienza en "dir" o -1
+static void soltar_segmento(int id_segmento);				// Elimina una referencia al segmento, liberandolo con la ultima
+static void liberar_segmentos();							// Suelta los segmentos abiertos por el proceso actual
 
 // Terminal
 static void iniciar_terminal();
+static char extraer_caracter();		// Saca el caracter mas antiguo del buffer. Debe haber alguno y llamarse con NIVEL_3
+static void volcar_estadisticas_terminal();	// Muestra los caracteres recibidos, perdidos y leidos. Se llama al quedar el sistema sin procesos
 
 // Llamadas al sistema
 static void tratar_llamsis();	// Tratamiento de llamadas al sistema
+
+// Grabacion y reproduccion de eventos externos
+static void iniciar_eventos_externos();	// Abre el fichero de grabacion o carga el de reproduccion segun el entorno
+static void grabar_evento(int tipo, int dato);	// Anota un evento externo con la posicion actual
+static void reproducir_eventos(int reloj_real);	// Entrega los eventos grabados hasta la posicion actual. Con reloj_real, como mucho un tick
+static void terminar_eventos_externos();	// Cierra la grabacion o comprueba la reproduccion. Se llama al quedar el sistema sin procesos
 int sis_crear_proceso();		// Tratamiento de llamada al sistema "crear_proceso". Llama a "crear_tarea"
 int sis_terminar_proceso();		// Tratamiento de llamada al sistema "terminar_proceso". Llama al "liberar_proceso"
 int sis_escribir();				// Tratamiento de llamada al sistema "escribir". Llama a "escribir_ker"
@@ -82,21 +246,242 @@ int sis_lock_mutex();
 int sis_unlock_mutex();
 int sis_cerrar_mutex();
 int sis_leer_caracter();	// 11/11/2018
+int sis_politica_mutex();	// Fija la politica de cesion de un mutex: FIFO | COMPETITIVA
+int sis_trylock_mutex();	// Lock que nunca bloquea
+int sis_lock_timeout_mutex();	// Lock que deja de esperar tras un numero de ciclos
+int sis_reservar_buffer();	// Reserva un buffer de mensaje del que es propietario el proceso actual
+int sis_liberar_buffer();
+int sis_crear_cola();		// Crea una cola de mensajes o devuelve la existente con ese nombre
+int sis_enviar();			// Cede un buffer a una cola de mensajes
+int sis_recibir();			// Obtiene el buffer mas antiguo de una cola de mensajes
+int sis_crear_memoria_compartida();
+int sis_abrir_memoria_compartida();
+int sis_cerrar_memoria_compartida();
+int sis_crear_hilo();			// Tratamiento de llamada al sistema "crear_hilo". Llama a "crear_hilo"
+int sis_datos_hilo();			// Devuelve la funcion y el argumento con los que se creo el hilo actual
+int sis_leer_caracter_nb();		// Lectura de terminal que devuelve -1 en vez de bloquear
+int sis_obtener_ticks();		// Numero de interrupciones de reloj desde el arranque
+int sis_esperar_evento();		// Bloquea hasta que pase un numero de ticks o, si se pide, haya un caracter en el terminal
+int sis_ceder_cpu();			// Pasa el proceso actual al final de la cola de listos
+int sis_dormir_ticks();
+int sis_dormir_ms();
+int sis_dormir_hasta();			// Duerme hasta un tick absoluto
+int sis_crear_temporizador();	// Crea un temporizador periodico del proceso actual
+int sis_esperar_temporizador();	// Espera el siguiente vencimiento de un temporizador
+int sis_destruir_temporizador();
+int sis_fijar_tiempo_real();	// Pasa el proceso actual a la clase de tiempo real (EDF) con un periodo y presupuesto en ticks
+int sis_esperar_periodo();		// Termina el trabajo del periodo actual y espera al siguiente
+int sis_plazos_perdidos();		// Numero de plazos perdidos por el proceso actual
+int sis_fijar_grupo();			// Cambia el grupo de cuota del proceso actual
+int sis_fijar_cuota();			// Fija los ticks de procesador por ventana de un grupo. 0 sin limite
+int sis_obtener_estadisticas();	// Copia las estadisticas de un proceso (-1 el actual) al buffer del usuario
+int sis_obtener_instantanea();	// Copia el estado de la tabla de procesos, las colas y los mutex a buffers del usuario
+int sis_obtener_perfil_mutex();	// Copia el perfil de contencion de una entrada de la tabla de mutex al buffer del usuario
+int sis_fijar_mascara_traza();	// Fija las categorias de eventos que se anotan en la traza. Devuelve la mascara anterior
+int sis_leer_traza();			// Copia los ultimos eventos de la traza, en orden cronologico, al buffer del usuario
+int sis_obtener_perfil_llamada();	// Copia el perfil de un servicio en un proceso (-1 el actual, PERFIL_SISTEMA todos) al buffer del usuario
+int sis_fijar_muestreo();		// Toma una muestra del contador de programa cada N ticks (0 desactiva). Devuelve el periodo anterior
+int sis_leer_muestras();		// Copia las muestras de un proceso (-1 el actual) al buffer del usuario
+int sis_resolver_direccion();	// Escribe "funcion (imagen)" para una direccion de codigo, segun los simbolos de la imagen cargada
+int sis_obtener_latencias();	// Copia las latencias de planificacion al buffer del usuario y opcionalmente las reinicia
+int sis_obtener_tiempo();		// Escribe los ticks y los nanosegundos desde el arranque en las direcciones no nulas
+int sis_obtener_pagina_tiempo();	// Escribe la direccion de la vista de solo lectura de la pagina de tiempo
+int sis_obtener_estadisticas_terminal();	// Copia las estadisticas del terminal al buffer del usuario y opcionalmente las reinicia
 
 /**
  * Definicion de los structs
  */
+/**
+ * Estadisticas de un proceso. Se copian tal cual al usuario: debe coincidir
+ * con struct estadisticas de usuario/include/servicios.h
+ */
+typedef struct estadisticas_proceso_t
+{
+	int id;
+	int estado;
+	int ticks_ejecucion;			// Ticks en los que el proceso estaba en ejecucion
+	int ticks_listo;				// Ticks en la cola de listos sin ejecutarse
+	int ticks_dormido;				// Ticks bloqueado por dormir() y sus variantes
+	int ticks_bloqueado_mutex;		// Ticks bloqueado en lock() o esperando un mutex libre
+	int ticks_bloqueado_terminal;	// Ticks bloqueado leyendo del terminal
+	int ticks_aparcado;				// Ticks sin presupuesto de tiempo real o sin cuota de grupo
+	int ticks_bloqueado_otros;		// Ticks bloqueado por otros motivos (colas de mensajes, plazos...)
+	int cambios_voluntarios;		// Veces que el proceso ha dejado el procesador por bloquearse o ceder_cpu
+	int cambios_involuntarios;		// Veces que ha sido expulsado
+	int llamadas_sistema;
+	unsigned long long creacion;	// Instante de creacion en milisegundos, segun leer_reloj_CMOS
+} estadisticas_proceso;
+
+/**
+ * Instantanea del sistema. Se copian tal cual al usuario: deben coincidir
+ * con los structs instantanea* de usuario/include/servicios.h
+ */
+typedef struct instantanea_proceso_t
+{
+	int id;
+	int estado;
+	int cola;				// COLA_* en la que esta el proceso
+	int lider;				// Id del lider. Igual a id si no es un hilo secundario
+	int grupo;
+	int tiempo_real;
+	int ticks_restantes;	// Ticks hasta despertar si duerme o hasta vencer su plazo. -1 sin plazo
+	int mutex_esperado;		// Id del mutex por el que espera en lock(). -1 si no espera ninguno
+} instantanea_proceso;
+
+typedef struct instantanea_mutex_t
+{
+	char nombre[MAX_NOM_MUT];
+	int id;
+	int estado;
+	int tipo;
+	int politica;
+	int propietario;		// Id del proceso que tiene el mutex bloqueado. -1 si nadie
+	int num_locks;
+	int bloqueados;			// Procesos esperando en lock()
+	int aperturas;			// Descriptores abiertos en todos los procesos
+} instantanea_mutex;
+
+typedef struct instantanea_t
+{
+	int ticks;
+	int proceso_actual;
+	int num_procesos;		// Entradas copiadas en el buffer de procesos
+	int num_mutex;			// Entradas copiadas en el buffer de mutex
+	int longitud_colas[NUM_COLAS_SISTEMA];
+} instantanea;
+
+/**
+ * Evento de la traza del kernel y estado de la traza. Se copian tal cual
+ * al usuario: deben coincidir con struct evento_traza y struct estado_traza
+ * de usuario/include/servicios.h
+ */
+typedef struct evento_traza_t
+{
+	unsigned long long ciclos;	// Instante del evento segun leer_ciclos
+	int tipo;					// TRAZA_CAMBIO_CONTEXTO | ENTRADA_LLAMADA | SALIDA_LLAMADA | BLOQUEO | DESPERTAR | INTERRUPCION
+	int proceso;				// Proceso en ejecucion al producirse el evento. -1 si no hay
+	int dato1;
+	int dato2;
+} evento_traza;
+
+typedef struct estado_traza_t
+{
+	int mascara;
+	unsigned int eventos;			// Eventos anotados desde el arranque, incluidos los sobrescritos
+	unsigned long long ciclos_inicio;	// Ciclo del arranque del kernel
+	unsigned long long ciclos_por_ms;	// Calibrado con el reloj CMOS al arrancar
+} estado_traza;
+
+/**
+ * Perfil de un servicio del kernel: llamadas completadas y su duracion en
+ * ciclos, desde que entran en tratar_llamsis hasta que devuelven el
+ * resultado (incluye el tiempo bloqueado). Se copia tal cual al usuario:
+ * debe coincidir con struct perfil_llamada de usuario/include/servicios.h
+ */
+typedef struct perfil_llamada_t
+{
+	int llamadas;
+	unsigned long long ciclos_total;
+	unsigned long long ciclos_min;
+	unsigned long long ciclos_max;
+	int histograma[NUM_CUBETAS_HISTOGRAMA];	// Cubeta i: llamadas que duraron [2^i, 2^(i+1)) ciclos
+} perfil_llamada;
+
+/**
+ * Pagina de tiempo que los procesos leen sin llamadas al sistema. El kernel
+ * la escribe a traves de tiempo_compartido y los procesos la ven en solo
+ * lectura en tiempo_compartido_usuario. Debe coincidir con struct
+ * pagina_tiempo de usuario/include/servicios.h
+ */
+typedef struct pagina_tiempo_t
+{
+	volatile int ticks;					// Copia de ticks_sistema, actualizada en int_reloj
+	unsigned long long ciclos_arranque;	// Calibracion de leer_ciclos para calcular nanosegundos
+	unsigned long long ciclos_por_ms;
+} pagina_tiempo;
+
+/**
+ * Latencias desde que un proceso pasa a listo hasta que el planificador lo
+ * elige, por motivo, y longitud de la cola de listos a lo largo del tiempo.
+ * Se copia tal cual al usuario: debe coincidir con struct latencias de
+ * usuario/include/servicios.h
+ */
+typedef struct latencias_planificacion_t
+{
+	int despachos[NUM_CAUSAS_LISTO];				// Veces que se ha elegido a un proceso que paso a listo por cada motivo
+	unsigned long long latencia_total[NUM_CAUSAS_LISTO];	// En ciclos de leer_ciclos
+	unsigned long long latencia_max[NUM_CAUSAS_LISTO];
+	int histograma[NUM_CAUSAS_LISTO][NUM_CUBETAS_HISTOGRAMA];	// Cubeta i: latencias de [2^i, 2^(i+1)) ciclos
+	int ticks;										// Ticks anotados desde el arranque o el ultimo reinicio
+	int ticks_con_longitud[MAX_PROC + 1];			// Ticks en los que habia i procesos esperando a ejecutar
+	int historial_listos[TAM_HISTORIAL_LISTOS];	// Procesos esperando en cada tick: el tick t esta en t % TAM_HISTORIAL_LISTOS
+} latencias_planificacion;
+
+/**
+ * Perfil de contencion de una entrada de la tabla de mutex. Se acumula
+ * aunque la entrada se reutilice para otros mutex. Los tiempos estan en
+ * ciclos de leer_ciclos. Se copia tal cual al usuario: debe coincidir con
+ * struct perfil_mutex de usuario/include/servicios.h
+ */
+typedef struct perfil_mutex_t
+{
+	char nombre[MAX_NOM_MUT];		// Nombre del ultimo mutex creado en la entrada
+	int adquisiciones;				// Veces que un proceso ha pasado a poseer el mutex
+	int adquisiciones_disputadas;	// Adquisiciones en las que el proceso tuvo que bloquearse
+	int liberaciones;
+	int max_bloqueados;				// Maximo de num_procesos_bloqueados alcanzado
+	unsigned long long espera_total;	// Desde que se bloquea en lock hasta que recibe el mutex
+	unsigned long long espera_max;
+	unsigned long long retencion_total;	// Desde que se recibe el mutex hasta que se suelta
+	unsigned long long retencion_max;
+	int histograma_espera[NUM_CUBETAS_HISTOGRAMA];		// Cubeta i: esperas en [2^i, 2^(i+1)) ciclos
+	int histograma_retencion[NUM_CUBETAS_HISTOGRAMA];
+} perfil_mutex;
+
 typedef struct BCP_t
 {
 	int id;						// Identificador del proceso
-	int estado;					// TERMINADO | LISTO | EJECUCION | BLOQUEADO*/
+	int estado;					// TERMINADO | LISTO | EJECUCION | BLOQUEADO | ZOMBI
 	contexto_t contexto_regs;	// Copia de los registros de la CPU
 	void * pila;				// Puntero al comienzo de la pila
 	BCP *siguiente;				// Puntero al proximo proceso en la lista contenedora
 	void *info_mem;				// Descritor del mapa de memoria
-	int ciclos_dormido;			// Numero de ciclos que restan para que el proceso despierte. Influenciado por la llamada al sistema dormir()
+	BCP *lider;					// Hilo que creo el proceso. Guarda los recursos compartidos por todos los hilos
+	int num_hilos;				// Numero de hilos vivos del proceso. Solo valido en el lider
+	void *funcion_hilo;			// Funcion y argumento con los que arranca un hilo. NULL en el lider
+	void *arg_hilo;
+	int tick_despertar;			// Tick absoluto en el que despierta el proceso dormido. Fijado por dormir() y sus variantes
+	int grupo;					// Grupo de cuota de procesador. Se hereda al crear procesos e hilos
+	int tiempo_real;			// Indica si el proceso pertenece a la clase de tiempo real (EDF)
+	int periodo;				// Ticks entre activaciones de la tarea de tiempo real
+	int presupuesto;			// Ticks de procesador que puede consumir la tarea en cada periodo
+	int presupuesto_restante;	// Ticks de presupuesto que quedan en el periodo actual
+	int utilizacion;			// presupuesto / periodo en milesimas. Reservada en el control de admision
+	int plazo;					// Tick absoluto en el que termina el periodo actual
+	int periodo_terminado;		// Indica si la tarea ha terminado el trabajo del periodo actual
+	int plazos_perdidos;		// Numero de periodos que han terminado sin que la tarea terminase su trabajo
+	BCP *siguiente_tiempo_real;	// Puntero a la proxima tarea en la lista de tareas de tiempo real
+	estadisticas_proceso estadisticas;	// Uso del procesador y esperas del proceso
+	int *ticks_situacion;		// Contador de estadisticas de la situacion actual del proceso. NULL si no cuenta
+	int tick_situacion;			// Tick en el que el proceso entro en esa situacion
+	perfil_llamada perfil_llamadas[NSERVICIOS];	// Llamadas al sistema hechas por este proceso o hilo
+	void *muestras[NUM_MUESTRAS];	// Contador de programa en los ticks muestreados en que ejecutaba este proceso
+	int num_muestras;
+	int muestras_perdidas;			// Muestras descartadas por estar lleno el buffer
+	unsigned long long instante_listo;	// Ciclo en el que paso a listo. 0 si ya se ha elegido desde entonces
+	int causa_listo;				// CAUSA_* por la que paso a listo
 	mutex *descriptores_mutex[NUM_MUT_PROC];	// Mutex poseidos por este proceso
+	mutex **descriptores_extra;					// Descriptores a partir de NUM_MUT_PROC, reservados dinamicamente
+	int num_descriptores;						// Numero total de descriptores del proceso (NUM_MUT_PROC + extra)
+	int segmentos_abiertos[NUM_SEGMENTOS];		// Numero de veces que el proceso ha abierto cada segmento de memoria compartida
 	int ciclos_en_ejecucion;					// Numero de ciclos que restan para que el round robin expulse a este proceso de ejecucion
+	mutex *mutex_esperado;						// Mutex por el que esta bloqueado el proceso en lock(). NULL si no espera ninguno
+	unsigned long long inicio_espera_mutex;		// Ciclo en el que se bloqueo en lock() por primera vez. 0 si no espera
+	int ciclos_plazo;							// Numero de ciclos que dura la espera del proceso bloqueado. -1 si espera indefinidamente
+	int tick_plazo;								// Tick absoluto en el que vence la espera. Solo valido si ciclos_plazo >= 0
+	BCP *siguiente_plazo;						// Puntero al proximo proceso en la lista de esperas con plazo
+	int plazo_vencido;							// Indica si el proceso fue despertado porque vencio el plazo de su espera
+	lista_BCPs *cola_espera;					// Cola de bloqueados en la que espera el proceso con plazo
 } BCP;
 
 typedef struct mutex_t
@@ -108,6 +493,10 @@ typedef struct mutex_t
 	int num_locks;				// Representa cuantos locks se han realizado sobre el mutex recursivo
 	int num_procesos_bloqueados;	// Numero de procesos bloqueados por el mutex en un instante de tiempo
 	int id_proc_bloq;			// ID del proceso que posee el mutex
+	int politica;				// Politica seguida al hacer unlock con procesos bloqueados: FIFO | COMPETITIVA
+	int num_aperturas;			// Numero de descriptores abiertos sobre el mutex en todos los procesos
+	unsigned long long inicio_retencion;	// Ciclo en el que el propietario actual recibio el mutex
+	perfil_mutex perfil;		// Contencion acumulada de esta entrada de la tabla
 } mutex;
 
 typedef struct servicio_t
@@ -121,26 +510,140 @@ typedef struct lista_t
 	BCP *ultimo;	// Puntero al ultimo elemento de la lista
 } lista_BCPs;
 
+typedef struct mensaje_t
+{
+	void *buffer;	// Datos del mensaje. Es un buffer_mensaje cuya propiedad se transfiere con el mensaje
+	int tam;		// Numero de bytes validos del mensaje
+} mensaje;
+
+typedef struct cola_mensajes_t
+{
+	char nombre[MAX_NOM_COLA];	// Nombre identificador y univoco de la cola
+	int usada;					// Indica si la entrada de la tabla de colas esta en uso
+	int capacidad;				// Numero maximo de mensajes en la cola
+	mensaje mensajes[MAX_MENSAJES_COLA];	// Buffer circular de mensajes
+	int primero;				// Indice del mensaje mas antiguo
+	int num_mensajes;			// Numero de mensajes en la cola
+	lista_BCPs emisores_bloqueados;		// Procesos bloqueados en enviar() porque la cola esta llena
+	lista_BCPs receptores_bloqueados;	// Procesos bloqueados en recibir() porque la cola esta vacia
+} cola_mensajes;
+
+typedef struct buffer_mensaje_t
+{
+	int marca;					// BUFFER_MARCA. Permite validar los punteros que pasan los procesos
+	int propietario;			// ID del proceso propietario. -1 si el buffer esta en una cola
+	int tam;					// Tamaño de los datos que siguen a la cabecera
+	buffer_mensaje *anterior;	// Lista doblemente enlazada de buffers reservados
+	buffer_mensaje *siguiente;
+} buffer_mensaje;
+
+typedef struct segmento_t
+{
+	char nombre[MAX_NOM_SEG];	// Nombre identificador y univoco del segmento
+	int usado;					// Indica si la entrada de la tabla de segmentos esta en uso
+	int tam;					// Tamaño pedido al crear el segmento
+	int primera_pagina;			// Primera pagina de la zona compartida asignada al segmento
+	int num_paginas;			// Numero de paginas contiguas asignadas
+	int referencias;			// Numero de aperturas del segmento en todos los procesos
+} segmento;
+
+typedef struct temporizador_t
+{
+	int usado;			// Indica si la entrada de la tabla de temporizadores esta en uso
+	int propietario;	// ID del proceso que creo el temporizador
+	int periodo;		// Ticks entre vencimientos
+	int proximo;		// Tick absoluto del proximo vencimiento
+} temporizador;
+
+typedef struct grupo_t
+{
+	int cuota;		// Ticks de procesador por ventana. 0 sin limite
+	int consumidos;	// Ticks consumidos por los procesos del grupo en la ventana actual
+} grupo;
+
 typedef struct terminal_t
 {
 	char buffer[TAM_BUF_TERM];
+	unsigned long long llegada[TAM_BUF_TERM];	// leer_ciclos al recibir cada caracter del buffer
 	int indice;
 	int indice_proc;
 	int elementos;
 } terminal;
 
+/**
+ * Evento externo grabado o por reproducir
+ */
+typedef struct evento_externo_t
+{
+	unsigned int posicion;	// llamadas_realizadas cuando llego
+	int tipo;				// EXTERNO_*
+	int dato;
+} evento_externo;
+
+/**
+ * Caracteres tratados por int_terminal y tiempo que pasan en el buffer
+ * hasta que un proceso los lee, en ciclos de leer_ciclos. Se copia tal cual
+ * al usuario: debe coincidir con struct estadisticas_terminal de
+ * usuario/include/servicios.h
+ */
+typedef struct estadisticas_terminal_t
+{
+	int recibidos;					// Interrupciones de terminal
+	int perdidos;					// Caracteres descartados por estar lleno el buffer
+	int leidos;						// Caracteres sacados del buffer por los procesos
+	unsigned long long espera_total;
+	unsigned long long espera_max;
+	int histograma[NUM_CUBETAS_HISTOGRAMA];	// Cubeta i: caracteres que esperaron [2^i, 2^(i+1)) ciclos
+} estadisticas_terminal;
+
 /**
  * Variables globales
  */
 BCP *p_proc_actual = NULL;		// Puntero al proceso en ejecucion
 BCP tabla_procs[MAX_PROC];		// Array que almacena los procesos iniciados
-mutex tabla_mutex[NUM_MUT];		// Array con todos los mutex del sistema disponibles
+mutex *tabla_mutex[MAX_MUT / NUM_MUT];	// Bloques de NUM_MUT mutex reservados a medida que hacen falta
+int num_bloques_mutex = 0;				// Numero de bloques reservados en tabla_mutex
 lista_BCPs cola_listos = { NULL, NULL };					// Cola de procesos listos
 lista_BCPs cola_bloqueados_dormir = { NULL, NULL };			// Cola de procesos bloqueados por la llamada al sistema dormir()
 lista_BCPs cola_bloqueados_mutex_libre = { NULL, NULL };	// Cola de procesos bloqueados por aquellos procesos que no obtuvieron ningun proceso
 lista_BCPs cola_bloqueados_mutex_lock = { NULL, NULL };		// Cola de procesos bloqueados por intentar hacer lock() sobre un mutex ya bloqueado
 lista_BCPs cola_bloqueados_terminal = { NULL, NULL };
+lista_BCPs cola_bloqueados_plazo = { NULL, NULL };			// Cola de procesos que solo esperan a que venza su plazo
+BCP *lista_plazos = NULL;		// Procesos bloqueados en una espera con plazo, ordenados por tick_plazo
+lista_BCPs cola_tiempo_real_agotados = { NULL, NULL };		// Tareas de tiempo real que han agotado su presupuesto hasta el siguiente periodo
+int utilizacion_tiempo_real = 0;	// Suma de la utilizacion de las tareas de tiempo real, en milesimas
+BCP *lista_tiempo_real = NULL;		// Tareas de tiempo real, esten listas o bloqueadas
+lista_BCPs cola_grupos_aparcados = { NULL, NULL };	// Procesos de grupos que han agotado su cuota hasta la siguiente ventana
+grupo tabla_grupos[NUM_GRUPOS];	// Cuota y consumo de cada grupo
+perfil_llamada perfil_llamadas[NSERVICIOS];	// Llamadas al sistema de todos los procesos desde el arranque
+int inicio_ventana = 0;			// Tick en el que comenzo la ventana de cuotas actual
 terminal terminal_sis;
+estadisticas_terminal estadisticas_term;	// Desde el arranque o el ultimo reinicio
+int modo_eventos = EVENTOS_NORMAL;
+unsigned int llamadas_realizadas = 0;	// Llamadas al sistema iniciadas desde el arranque
+FILE *fichero_eventos = NULL;			// Grabacion en curso
+evento_externo *eventos_externos = NULL;	// Eventos cargados para reproducir
+int num_eventos_externos = 0;
+int siguiente_evento_externo = 0;		// Primer evento aun no reproducido
+evento_traza traza[TAM_TRAZA];	// Buffer circular con los ultimos TAM_TRAZA eventos
+unsigned int traza_siguiente = 0;	// Eventos anotados desde el arranque. traza_siguiente % TAM_TRAZA es la entrada a escribir
+int mascara_traza = MASCARA_TRAZA_INICIAL;	// Categorias TRAZA_* que se anotan
+unsigned long long ciclos_arranque = 0;	// leer_ciclos al arrancar, origen de la traza y de obtener_tiempo
+unsigned long long ciclos_por_ms = 0;	// Ciclos de leer_ciclos por milisegundo del reloj CMOS
+pagina_tiempo pagina_tiempo_estatica __attribute__((aligned(TAM_PAGINA)));	// Se usa si no se puede crear la pagina de solo lectura
+pagina_tiempo *tiempo_compartido = &pagina_tiempo_estatica;			// Vista del kernel de la pagina de tiempo
+const pagina_tiempo *tiempo_compartido_usuario = &pagina_tiempo_estatica;	// Vista de solo lectura que se da a los procesos
+int periodo_muestreo = 0;			// Ticks entre muestras del contador de programa. 0 desactivado
+void *pc_interrumpido = NULL;		// Contador de programa en el que se produjo la ultima senal de reloj
+struct sigaction manejador_reloj_hal;	// Manejador de SIGALRM instalado por el HAL, al que llama capturar_pc
+latencias_planificacion latencias;		// Latencias de planificacion desde el arranque o el ultimo reinicio
+int ticks_sistema = 0;		// Interrupciones de reloj tratadas desde el arranque
+cola_mensajes tabla_colas[NUM_COLAS];	// Array con todas las colas de mensajes del sistema
+buffer_mensaje *buffers_reservados = NULL;	// Lista de buffers de mensaje reservados
+segmento tabla_segmentos[NUM_SEGMENTOS];	// Array con todos los segmentos de memoria compartida
+char zona_compartida[NUM_PAGINAS_COMPARTIDAS * TAM_PAGINA] __attribute__((aligned(TAM_PAGINA)));	// Memoria repartida entre los segmentos
+int paginas_compartidas[NUM_PAGINAS_COMPARTIDAS];	// Segmento al que esta asignada cada pagina. -1 si esta libre
+temporizador tabla_temporizadores[NUM_TEMPORIZADORES];	// Array con todos los temporizadores periodicos
 
 // Array que contiene los punteros a las funciones que manejan las llamadas al sistema
 servicio tabla_servicios[NSERVICIOS] =	{	{sis_crear_proceso},
@@ -153,6 +656,47 @@ servicio tabla_servicios[NSERVICIOS] =	{	{sis_crear_proceso},
 											{sis_lock_mutex},
 											{sis_unlock_mutex},
 											{sis_cerrar_mutex},
-											{sis_leer_caracter}
+											{sis_leer_caracter},
+											{sis_politica_mutex},
+											{sis_trylock_mutex},
+											{sis_lock_timeout_mutex},
+											{sis_reservar_buffer},
+											{sis_liberar_buffer},
+											{sis_crear_cola},
+											{sis_enviar},
+											{sis_recibir},
+											{sis_crear_memoria_compartida},
+											{sis_abrir_memoria_compartida},
+											{sis_cerrar_memoria_compartida},
+											{sis_crear_hilo},
+											{sis_datos_hilo},
+											{sis_leer_caracter_nb},
+											{sis_obtener_ticks},
+											{sis_esperar_evento},
+											{sis_ceder_cpu},
+											{sis_dormir_ticks},
+											{sis_dormir_ms},
+											{sis_dormir_hasta},
+											{sis_crear_temporizador},
+											{sis_esperar_temporizador},
+											{sis_destruir_temporizador},
+											{sis_fijar_tiempo_real},
+											{sis_esperar_periodo},
+											{sis_plazos_perdidos},
+											{sis_fijar_grupo},
+											{sis_fijar_cuota},
+											{sis_obtener_estadisticas},
+											{sis_obtener_instantanea},
+											{sis_obtener_perfil_mutex},
+											{sis_fijar_mascara_traza},
+											{sis_leer_traza},
+											{sis_obtener_perfil_llamada},
+											{sis_fijar_muestreo},
+											{sis_leer_muestras},
+											{sis_resolver_direccion},
+											{sis_obtener_latencias},
+											{sis_obtener_tiempo},
+											{sis_obtener_pagina_tiempo},
+											{sis_obtener_estadisticas_terminal}
 										};
 #endif /* _KERNEL_H */
\ No newline at end of file
@@ -19,7 +19,7 @@
 #define _LLAMSIS_H
 
 /* Numero de llamadas disponibles */
-#define NSERVICIOS 11
+#define NSERVICIOS 52
 
 #define CREAR_PROCESO 0
 #define TERMINAR_PROCESO 1
@@ -35,5 +35,70 @@
 #define UNLOCK_MUTEX 8
 #define CERRAR_MUTEX 9
 #define LEER_CARACTER 10
+#define POLITICA_MUTEX 11
+#define TRYLOCK_MUTEX 12
+#define LOCK_TIMEOUT_MUTEX 13
+/**
+ * Colas de mensajes
+ */
+#define RESERVAR_BUFFER 14
+#define LIBERAR_BUFFER 15
+#define CREAR_COLA 16
+#define ENVIAR 17
+#define RECIBIR 18
+/**
+ * Memoria compartida
+ */
+#define CREAR_MEMORIA_COMPARTIDA 19
+#define ABRIR_MEMORIA_COMPARTIDA 20
+#define CERRAR_MEMORIA_COMPARTIDA 21
+/**
+ * Hilos
+ */
+#define CREAR_HILO 22
+#define DATOS_HILO 23
+/**
+ * Terminal y reloj sin bloqueo. Usadas por la biblioteca de corrutinas
+ */
+#define LEER_CARACTER_NB 24
+#define OBTENER_TICKS 25
+#define ESPERAR_EVENTO 26
+#define CEDER_CPU 27
+/**
+ * Dormir con resolucion de tick y temporizadores periodicos
+ */
+#define DORMIR_TICKS 28
+#define DORMIR_MS 29
+#define DORMIR_HASTA 30
+#define CREAR_TEMPORIZADOR 31
+#define ESPERAR_TEMPORIZADOR 32
+#define DESTRUIR_TEMPORIZADOR 33
+/**
+ * Planificacion de tiempo real (EDF)
+ */
+#define FIJAR_TIEMPO_REAL 34
+#define ESPERAR_PERIODO 35
+#define PLAZOS_PERDIDOS 36
+/**
+ * Grupos con cuota de procesador
+ */
+#define FIJAR_GRUPO 37
+#define FIJAR_CUOTA 38
+/**
+ * Introspeccion, perfiles y traza
+ */
+#define OBTENER_ESTADISTICAS 39
+#define OBTENER_INSTANTANEA 40
+#define OBTENER_PERFIL_MUTEX 41
+#define FIJAR_MASCARA_TRAZA 42
+#define LEER_TRAZA 43
+#define OBTENER_PERFIL_LLAMADA 44
+#define FIJAR_MUESTREO 45
+#define LEER_MUESTRAS 46
+#define RESOLVER_DIRECCION 47
+#define OBTENER_LATENCIAS 48
+#define OBTENER_TIEMPO 49
+#define OBTENER_PAGINA_TIEMPO 50
+#define OBTENER_ESTADISTICAS_TERMINAL 51
 #endif /* _LLAMSIS_H */
 
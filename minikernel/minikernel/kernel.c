@@ -4,8 +4,15 @@
  * Fernando Perez Costoya
  */
 
+#define _GNU_SOURCE // REG_RIP y dladdr, usados por el muestreo del contador de programa
 #include "kernel.h" // Contiene definiciones usadas por este modulo
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 static void iniciar_tabla_proc()
 {
@@ -41,6 +48,36 @@ static void insertar_ultimo(lista_BCPs *lista, BCP *proc)
 	proc->siguiente = NULL;
 }
 
+static void insertar_listo(BCP *proc, int causa)
+{
+	marcar_listo(proc, causa);
+
+	// Los procesos normales de un grupo que ha agotado su cuota esperan a la siguiente ventana
+	if (!proc->tiempo_real && grupo_agotado(proc->grupo))
+	{
+		proc->estado = BLOQUEADO;
+		proc->cola_espera = &cola_grupos_aparcados;
+		insertar_ultimo(&cola_grupos_aparcados, proc);
+	}
+	else
+	{
+		proc->estado = LISTO;
+		insertar_ultimo(&cola_listos, proc);
+	}
+	contabilizar(proc, 0);
+	TRAZAR(TRAZA_ESPERAS, TRAZA_DESPERTAR, proc->id, 0);
+}
+
+static void insertar_primero(lista_BCPs *lista, BCP *proc)
+{
+	if (lista->primero == NULL)
+	{
+		lista->ultimo = proc;
+	}
+	proc->siguiente = lista->primero;
+	lista->primero = proc;
+}
+
 static void eliminar_primero(lista_BCPs *lista)
 {
 	if (lista->ultimo == lista->primero)
@@ -86,44 +123,263 @@ static void espera_int()
 	fijar_nivel_int(nivel);
 }
 
+// Puede llamarse ya en NIVEL_3 para comprobar la condicion de espera y encolarse sin que una
+// interrupcion se cuele entre ambas cosas; el proceso vuelve a ese nivel al despertar
+static void bloquear(lista_BCPs *cola, int ciclos_plazo)
+{
+	BCP *proceso_a_bloquear = p_proc_actual;
+
+	// Agotar el presupuesto o la cuota es una expulsion; el resto de esperas las pide el proceso
+	if (cola == &cola_tiempo_real_agotados || cola == &cola_grupos_aparcados)
+	{
+		proceso_a_bloquear->estadisticas.cambios_involuntarios++;
+	}
+	else
+	{
+		proceso_a_bloquear->estadisticas.cambios_voluntarios++;
+	}
+
+	proceso_a_bloquear->estado = BLOQUEADO;
+	proceso_a_bloquear->ciclos_plazo = ciclos_plazo;
+	proceso_a_bloquear->plazo_vencido = 0;
+	proceso_a_bloquear->cola_espera = cola;
+	contabilizar(proceso_a_bloquear, 0);
+	TRAZAR(TRAZA_ESPERAS, TRAZA_BLOQUEO, identificar_cola(cola), 0);
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	eliminar_elem(&cola_listos, proceso_a_bloquear);
+	insertar_ultimo(cola, proceso_a_bloquear);
+
+	// Las esperas con plazo se ordenan por vencimiento para que el tick solo mire la cabeza
+	if (ciclos_plazo >= 0)
+	{
+		proceso_a_bloquear->tick_plazo = ticks_sistema + ciclos_plazo;
+		BCP **enlace = &lista_plazos;
+		while (*enlace != NULL && (*enlace)->tick_plazo - proceso_a_bloquear->tick_plazo <= 0)
+		{
+			enlace = &((*enlace)->siguiente_plazo);
+		}
+		proceso_a_bloquear->siguiente_plazo = *enlace;
+		*enlace = proceso_a_bloquear;
+	}
+
+	p_proc_actual = planificador();
+
+	// El nivel se restaura al volver a este proceso: con p_proc_actual ya cambiado, un tick antes
+	// de cambio_contexto guardaria esta pila en el contexto del proceso elegido
+	cambio_contexto(&(proceso_a_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
+	fijar_nivel_int(nivel);
+}
+
+static void vencer_plazo(BCP *proc)
+{
+	// Deshacer la espera segun su motivo
+	if (proc->mutex_esperado != NULL)
+	{
+		proc->mutex_esperado->num_procesos_bloqueados--;
+		proc->mutex_esperado = NULL;
+		proc->inicio_espera_mutex = 0;
+	}
+
+	proc->estado = LISTO;
+	quitar_plazo(proc);
+	proc->plazo_vencido = 1;
+	eliminar_elem(proc->cola_espera, proc);
+	proc->cola_espera = NULL;
+	insertar_listo(proc, CAUSA_PLAZO);
+}
+
+static void quitar_plazo(BCP *proc)
+{
+	if (proc->ciclos_plazo < 0)
+	{
+		return;
+	}
+	BCP **enlace = &lista_plazos;
+	while (*enlace != proc)
+	{
+		enlace = &((*enlace)->siguiente_plazo);
+	}
+	*enlace = proc->siguiente_plazo;
+	proc->ciclos_plazo = -1;
+}
+
 static BCP *planificador()
 {
+	int saliente = (p_proc_actual != NULL) ? p_proc_actual->id : -1;
+	if (cola_listos.primero == NULL)
+	{
+		// En la traza el procesador queda ocioso (proceso -1) hasta que haya alguno listo
+		TRAZAR(TRAZA_PLANIFICACION, TRAZA_CAMBIO_CONTEXTO, saliente, -1);
+		saliente = -1;
+	}
 	while (cola_listos.primero == NULL)
 	{
 		// No hay nada que hacer
 		espera_int();
 	}
+
+	// Las tareas de tiempo real tienen prioridad. Se adelanta la elegida para que el proceso en ejecucion siga en cabeza
+	BCP *elegido = elegir_tiempo_real();
+	if (elegido != NULL && elegido != cola_listos.primero)
+	{
+		eliminar_elem(&cola_listos, elegido);
+		insertar_primero(&cola_listos, elegido);
+	}
+
+	if (cola_listos.primero != p_proc_actual || saliente == -1)
+	{
+		TRAZAR(TRAZA_PLANIFICACION, TRAZA_CAMBIO_CONTEXTO, saliente, cola_listos.primero->id);
+	}
+	// El saliente pasa a contar como listo, bloqueado o terminado; los ticks de espera ya son suyos
+	if (p_proc_actual != NULL && p_proc_actual != cola_listos.primero)
+	{
+		contabilizar(p_proc_actual, 0);
+	}
+	contabilizar(cola_listos.primero, 1);
+	anotar_despacho(cola_listos.primero);
 	return cola_listos.primero;
 }
 
+static BCP *elegir_tiempo_real()
+{
+	BCP *elegido = NULL;
+	for (BCP *p_proc = cola_listos.primero; p_proc != NULL; p_proc = p_proc->siguiente)
+	{
+		if (p_proc->tiempo_real && (elegido == NULL || p_proc->plazo - elegido->plazo < 0))
+		{
+			elegido = p_proc;
+		}
+	}
+	return elegido;
+}
+
+static void nuevo_periodo(BCP *proc)
+{
+	// Cada periodo que vence sin que la tarea haya llamado a esperar_periodo es un plazo perdido
+	int perdidos = proc->periodo_terminado ? 0 : 1;
+	proc->plazo += proc->periodo;
+	while (ticks_sistema - proc->plazo >= 0)
+	{
+		proc->plazo += proc->periodo;
+		perdidos++;
+	}
+	if (perdidos > 0)
+	{
+		proc->plazos_perdidos += perdidos;
+		DEPURAR("\tEl proceso %d ha perdido %d plazos (%d en total)\n", proc->id, perdidos, proc->plazos_perdidos);
+	}
+
+	proc->presupuesto_restante = proc->presupuesto;
+	proc->periodo_terminado = 0;
+
+	// Una tarea que agoto su presupuesto vuelve a estar lista
+	if (proc->estado == BLOQUEADO && proc->cola_espera == &cola_tiempo_real_agotados)
+	{
+		proc->estado = LISTO;
+		proc->cola_espera = NULL;
+		eliminar_elem(&cola_tiempo_real_agotados, proc);
+		insertar_listo(proc, CAUSA_TIEMPO_REAL);
+	}
+}
+
+static void salir_tiempo_real(BCP *proc)
+{
+	if (!proc->tiempo_real)
+	{
+		return;
+	}
+	utilizacion_tiempo_real -= proc->utilizacion;
+	proc->tiempo_real = 0;
+
+	BCP **enlace = &lista_tiempo_real;
+	while (*enlace != proc)
+	{
+		enlace = &((*enlace)->siguiente_tiempo_real);
+	}
+	*enlace = proc->siguiente_tiempo_real;
+}
+
 static void liberar_proceso()
 {
-	printk("[LIBERAR_PROCESO()]\n");
+	DEPURAR("[LIBERAR_PROCESO()]\n");
 
-	// Cerrar los mutex implicados
-	for (int descriptor = 0; descriptor != NUM_MUT_PROC; ++descriptor)
+	// Deja libre la utilizacion reservada por la tarea de tiempo real
+	salir_tiempo_real(p_proc_actual);
+
+	BCP *lider = p_proc_actual->lider;
+	lider->num_hilos--;
+	if (lider->num_hilos > 0)
 	{
-		mutex *mutex_i = p_proc_actual->descriptores_mutex[descriptor];
-		if (mutex_i != NULL)
+		// Quedan otros hilos en el proceso: solo se sueltan los mutex que posee este hilo
+		DEPURAR("\tTermina un hilo del proceso %d. Quedan %d hilos\n", lider->id, lider->num_hilos);
+		for (int descriptor = 0; descriptor != lider->num_descriptores; ++descriptor)
 		{
-			if (mutex_i->id_proc_bloq == p_proc_actual->id)
+			mutex *mutex_i = obtener_descriptor(lider, descriptor);
+			if (mutex_i != NULL && mutex_i->estado == MUTEX_ESTADO_BLOQUEADO && mutex_i->id_proc_bloq == p_proc_actual->id)
 			{
-				printk("\tSe va a cerrar el mutex con descriptor %d\n", descriptor);
-				cerrar(descriptor, mutex_i);
+				mutex_i->num_locks = 0;
+				unlock(descriptor, mutex_i);
 			}
 		}
+
+		// El lider conserva su BCP hasta que termine el ultimo hilo
+		p_proc_actual->estado = (p_proc_actual == lider) ? ZOMBI : TERMINADO;
 	}
+	else
+	{
+		// Cerrar todos los mutex abiertos por el proceso
+		for (int descriptor = 0; descriptor != lider->num_descriptores; ++descriptor)
+		{
+			mutex *mutex_i = obtener_descriptor(lider, descriptor);
+			if (mutex_i != NULL)
+			{
+				DEPURAR("\tSe va a cerrar el mutex con descriptor %d\n", descriptor);
+				cerrar(descriptor, mutex_i);
+			}
+		}
+		free(lider->descriptores_extra);
+		lider->descriptores_extra = NULL;
+		lider->num_descriptores = NUM_MUT_PROC;
+
+		liberar_buffers(); // Los buffers que estan en colas sobreviven al proceso
+		liberar_segmentos();
+		liberar_temporizadores();
+
+		// El HAL apaga el sistema al liberar la ultima imagen: antes se vuelcan los perfiles
+		int otros_procesos = 0;
+		for (int i = 0; i != MAX_PROC; ++i)
+		{
+			if (tabla_procs[i].estado != NO_USADA && tabla_procs[i].lider != lider)
+			{
+				otros_procesos++;
+			}
+		}
+		if (otros_procesos == 0)
+		{
+			volcar_perfil_mutex();
+			volcar_perfil_llamadas();
+			volcar_estadisticas_terminal();
+			terminar_eventos_externos();
+		}
 
-	liberar_imagen(p_proc_actual->info_mem); // Liberar mapa de memoria
+		liberar_imagen(lider->info_mem); // Liberar mapa de memoria
+
+		lider->estado = TERMINADO; // Libera tambien el BCP del lider si ya habia terminado
+		p_proc_actual->estado = TERMINADO;
+	}
 
-	p_proc_actual->estado = TERMINADO;
+	// El proceso no vuelve a ejecutarse: no se baja de NIVEL_3 para que un tick no lo expulse
+	// cuando p_proc_actual ya es el siguiente
+	fijar_nivel_int(NIVEL_3);
 	eliminar_elem(&cola_listos, p_proc_actual); // Se elimina el proceso de la cola de listos
 
 	// Se realiza el cambio de contexto
 	BCP *p_proc_anterior = p_proc_actual;
 	p_proc_actual = planificador();
 
-	printk("\nEl proceso %d ha finalizado su ejecución. Cambio de contexto al proceso %d\n",
+	DEPURAR("\nEl proceso %d ha finalizado su ejecución. Cambio de contexto al proceso %d\n",
 		   p_proc_anterior->id, p_proc_actual->id);
 
 	liberar_pila(p_proc_anterior->pila);
@@ -133,46 +389,65 @@ static void liberar_proceso()
 
 static void exc_arit()
 {
-	printk("[EXC_ARIT()]\n");
+	DEPURAR("[EXC_ARIT()]\n");
 	if (!viene_de_modo_usuario())
 	{
 		panico("\tExcepción aritmética cuando se estaba dentro del kernel");
 	}
 
-	printk("\tExcepción aritmética producida por el proceso %d\n", p_proc_actual->id);
+	DEPURAR("\tExcepción aritmética producida por el proceso %d\n", p_proc_actual->id);
 	liberar_proceso();
 	return; // No se deberia llegar aqui
 }
 
 static void exc_mem()
 {
-	printk("[EXC_MEM()]\n");
+	DEPURAR("[EXC_MEM()]\n");
 	if (!viene_de_modo_usuario())
 	{
 		panico("\tExcepción de memoria cuando se estaba dentro del kernel");
 	}
 
-	printk("\tExcepción de memoria producida por el proceso %d\n", p_proc_actual->id);
+	DEPURAR("\tExcepción de memoria producida por el proceso %d\n", p_proc_actual->id);
 	liberar_proceso();
 	return; // No se deberia llegar aqui
 }
 
 static void int_terminal()
 {
-	printk("[INT_TERMINAL()]\n");
+	DEPURAR("[INT_TERMINAL()]\n");
+	TRAZAR(TRAZA_INTERRUPCIONES, TRAZA_INTERRUPCION, INT_TERMINAL, 0);
 	char car = leer_puerto(DIR_TERMINAL);
-	printk("\tTratando interrupción de terminal. Caracter: %c\n", car);
+	DEPURAR("\tTratando interrupción de terminal. Caracter: %c\n", car);
+
+	if (modo_eventos == EVENTOS_REPRODUCIR)
+	{
+		DEPURAR("\tReproduciendo: se ignora el caracter %c\n", car);
+		return;
+	}
+	if (modo_eventos == EVENTOS_GRABAR)
+	{
+		grabar_evento(EXTERNO_TERMINAL, car);
+	}
+	recibir_caracter(car);
+}
+
+static void recibir_caracter(char car)
+{
+	estadisticas_term.recibidos++;
 
 	if (terminal_sis.elementos == TAM_BUF_TERM)
 	{
-		printk("\tEl buffer está lleno. Se ignora el caracter %c\n", car);
+		DEPURAR("\tEl buffer está lleno. Se ignora el caracter %c\n", car);
+		estadisticas_term.perdidos++;
 	}
 	else
 	{
 		terminal_sis.buffer[terminal_sis.indice] = car;
+		terminal_sis.llegada[terminal_sis.indice] = leer_ciclos();
 		terminal_sis.elementos++;
 
-		printk("\tSe ha introducido en la posicion %d el caracter %c. Hay %d espacios ocupados en el buffer\n",
+		DEPURAR("\tSe ha introducido en la posicion %d el caracter %c. Hay %d espacios ocupados en el buffer\n",
 			terminal_sis.indice, car, terminal_sis.elementos);
 
 		terminal_sis.indice++;
@@ -184,18 +459,13 @@ static void int_terminal()
 
 	if (cola_bloqueados_terminal.primero == NULL)
 	{
-		printk("\tNo hay procesos bloqueados por [SIS_LEER_TERMINAL]\n");
+		DEPURAR("\tNo hay procesos bloqueados por [SIS_LEER_TERMINAL]\n");
 		return;
 	}
 
-	BCP *p_proc = cola_bloqueados_terminal.primero;
-
-	int nivel = fijar_nivel_int(NIVEL_3);
-
-	eliminar_elem(&cola_bloqueados_terminal, p_proc);
-	insertar_ultimo(&cola_listos, p_proc);
-
-	fijar_nivel_int(nivel);
+	// Se despierta a todos: unos leen el caracter y otros solo esperaban un evento
+	while (despertar_primero(&cola_bloqueados_terminal) != NULL)
+		;
 
 	return;
 }
@@ -204,19 +474,26 @@ static void int_reloj()
 {
 	// printk("[INT_RELOJ()]");
 	// printk("\tTratando interrupción de reloj\n");
+	TRAZAR(TRAZA_INTERRUPCIONES, TRAZA_INTERRUPCION, INT_RELOJ, 0);
 
-	// Round robin
-	if (cola_listos.primero != NULL) // Evitar que el proceso esperando por interrupciones vuelva a ejecutarse
+	if (modo_eventos == EVENTOS_REPRODUCIR)
 	{
-		int id = p_proc_actual->id;
-		int ciclos = p_proc_actual->ciclos_en_ejecucion;
-		// printk("\tAl proceso %d le restan %d ciclos en ejecución\n", id, ciclos);
-		if (p_proc_actual->ciclos_en_ejecucion == 0)
-		{
-			int_sw();
-		}
-		p_proc_actual->ciclos_en_ejecucion--;
+		reproducir_eventos(1);
+		return;
+	}
+	if (modo_eventos == EVENTOS_GRABAR)
+	{
+		grabar_evento(EXTERNO_RELOJ, 0);
 	}
+	tratar_tick();
+}
+
+static void tratar_tick()
+{
+	ticks_sistema++;
+	tiempo_compartido->ticks = ticks_sistema;
+	tomar_muestra();
+	anotar_longitud_listos();
 
 	// Despertar a los procesos dormidos
 	BCP *p_proc = cola_bloqueados_dormir.primero;
@@ -228,43 +505,190 @@ static void int_reloj()
 
 	while (p_proc != NULL)
 	{
-		// printk("\tID: %d, Ciclos dormido: %d\n!", p_proc->id, p_proc->ciclos_dormido);
+		// printk("\tID: %d, Despierta en el tick: %d\n!", p_proc->id, p_proc->tick_despertar);
 
-		if (p_proc->ciclos_dormido == 0)
+		BCP *p_proximo = p_proc->siguiente;
+		if (ticks_sistema - p_proc->tick_despertar >= 0)
 		{
 			// printk("\tID: %d se ha despertado\n", p_proc->id);
 
-			BCP *p_proximo = p_proc->siguiente;
-
 			p_proc->estado = LISTO;
-			p_proc->ciclos_dormido = -1;
+			p_proc->cola_espera = NULL;
 			eliminar_elem(&cola_bloqueados_dormir, p_proc);
-			insertar_ultimo(&cola_listos, p_proc);
+			insertar_listo(p_proc, CAUSA_DORMIR);
+		}
+		p_proc = p_proximo;
+	}
+
+	// Vencer los plazos de los procesos bloqueados en una espera limitada. Como dormir_ticks,
+	// una espera de N ciclos vence en el N-esimo tick
+	while (lista_plazos != NULL && ticks_sistema - lista_plazos->tick_plazo >= 0)
+	{
+		vencer_plazo(lista_plazos);
+	}
+
+	// Comienzo de una ventana de cuotas de procesador
+	if (ticks_sistema - inicio_ventana >= VENTANA_CUOTA)
+	{
+		nueva_ventana();
+	}
 
-			p_proc = p_proximo;
+	// Comienzo de periodo de las tareas de tiempo real
+	for (p_proc = lista_tiempo_real; p_proc != NULL; p_proc = p_proc->siguiente_tiempo_real)
+	{
+		if (ticks_sistema - p_proc->plazo >= 0)
+		{
+			nuevo_periodo(p_proc);
 		}
-		else
+	}
+
+	// Lo que sigue puede expulsar al proceso actual y se hace lo ultimo: int_sw no vuelve hasta que
+	// el proceso expulsado se ejecute de nuevo. Si el planificador esta esperando una interrupcion
+	// p_proc_actual no esta en ejecucion
+	if (cola_listos.primero == NULL || p_proc_actual->estado != LISTO)
+	{
+		return;
+	}
+
+	// Presupuesto de las tareas de tiempo real
+	if (p_proc_actual->tiempo_real)
+	{
+		p_proc_actual->presupuesto_restante--;
+		if (p_proc_actual->presupuesto_restante <= 0)
+		{
+			DEPURAR("\tEl proceso %d ha agotado su presupuesto. Espera hasta el tick %d\n", p_proc_actual->id, p_proc_actual->plazo);
+			bloquear(&cola_tiempo_real_agotados, -1);
+			return;
+		}
+	}
+
+	// Cuota del grupo de los procesos normales
+	if (!p_proc_actual->tiempo_real)
+	{
+		int id_grupo = p_proc_actual->grupo;
+		tabla_grupos[id_grupo].consumidos++;
+		if (grupo_agotado(id_grupo))
+		{
+			DEPURAR("\tEl grupo %d ha agotado su cuota. Se aparca hasta el tick %d\n", id_grupo, inicio_ventana + VENTANA_CUOTA);
+			aparcar_grupo(id_grupo);
+			bloquear(&cola_grupos_aparcados, -1);
+			return;
+		}
+	}
+
+	// Expulsion por una tarea de tiempo real con un plazo mas cercano
+	BCP *elegido = elegir_tiempo_real();
+	if (elegido != NULL && elegido != p_proc_actual &&
+		(!p_proc_actual->tiempo_real || elegido->plazo - p_proc_actual->plazo < 0))
+	{
+		p_proc_actual->estadisticas.cambios_involuntarios++;
+		int_sw();
+		return;
+	}
+
+	// Round robin entre los procesos normales
+	if (!p_proc_actual->tiempo_real)
+	{
+		p_proc_actual->ciclos_en_ejecucion--;
+		// printk("\tAl proceso %d le restan %d ciclos en ejecución\n", p_proc_actual->id, p_proc_actual->ciclos_en_ejecucion);
+		if (p_proc_actual->ciclos_en_ejecucion <= 0)
 		{
-			p_proc->ciclos_dormido--;
-			p_proc = p_proc->siguiente;
+			p_proc_actual->estadisticas.cambios_involuntarios++;
+			int_sw();
 		}
 	}
 	return;
 }
 
+// Los ticks de cada situacion se cargan al salir de ella, en lugar de recorrer todos los
+// procesos en cada tick. El tick t se carga a la situacion en la que estaba el proceso
+// cuando llego, como si se contara al principio de tratar_tick
+static void contabilizar(BCP *proc, int en_ejecucion)
+{
+	cargar_ticks(proc);
+
+	estadisticas_proceso *est = &(proc->estadisticas);
+	if (en_ejecucion)
+	{
+		proc->ticks_situacion = &(est->ticks_ejecucion);
+	}
+	else if (proc->estado == LISTO)
+	{
+		proc->ticks_situacion = &(est->ticks_listo);
+	}
+	else if (proc->estado == BLOQUEADO)
+	{
+		// El motivo se deduce de la cola en la que espera
+		lista_BCPs *cola = proc->cola_espera;
+		if (cola == &cola_bloqueados_dormir)
+		{
+			proc->ticks_situacion = &(est->ticks_dormido);
+		}
+		else if (cola == &cola_bloqueados_mutex_lock || cola == &cola_bloqueados_mutex_libre)
+		{
+			proc->ticks_situacion = &(est->ticks_bloqueado_mutex);
+		}
+		else if (cola == &cola_bloqueados_terminal)
+		{
+			proc->ticks_situacion = &(est->ticks_bloqueado_terminal);
+		}
+		else if (cola == &cola_tiempo_real_agotados || cola == &cola_grupos_aparcados)
+		{
+			proc->ticks_situacion = &(est->ticks_aparcado);
+		}
+		else
+		{
+			proc->ticks_situacion = &(est->ticks_bloqueado_otros);
+		}
+	}
+	else
+	{
+		proc->ticks_situacion = NULL; // Terminado o zombi
+	}
+}
+
+static void cargar_ticks(BCP *proc)
+{
+	if (proc->ticks_situacion != NULL)
+	{
+		*(proc->ticks_situacion) += ticks_sistema - proc->tick_situacion;
+	}
+	proc->tick_situacion = ticks_sistema;
+}
+
 static void tratar_llamsis()
 {
 	// printk("[TRATAR_LLAMSIS()]\n");
 	int res;
 	int nserv = leer_registro(0);
-	if (nserv < NSERVICIOS)
+
+	// Los eventos grabados antes de esta llamada se entregan ahora, como si la interrupcion
+	// hubiera llegado justo antes. Un tick puede expulsar al proceso antes de que siga
+	if (modo_eventos == EVENTOS_REPRODUCIR)
+	{
+		int nivel = fijar_nivel_int(NIVEL_3);
+		reproducir_eventos(0);
+		fijar_nivel_int(nivel);
+	}
+	llamadas_realizadas++;
+
+	p_proc_actual->estadisticas.llamadas_sistema++;
+	TRAZAR(TRAZA_LLAMADAS, TRAZA_ENTRADA_LLAMADA, nserv, 0);
+	unsigned long long inicio = PERFIL_LLAMADAS ? leer_ciclos() : 0;
+	if (nserv >= 0 && nserv < NSERVICIOS)
 	{
 		res = (tabla_servicios[nserv].fservicio)();
+		if (PERFIL_LLAMADAS)
+		{
+			// Si la llamada se ha bloqueado p_proc_actual vuelve a ser quien la hizo
+			anotar_llamada(nserv, leer_ciclos() - inicio);
+		}
 	}
 	else
 	{
 		res = -1; // Servicio no existente
 	}
+	TRAZAR(TRAZA_LLAMADAS, TRAZA_SALIDA_LLAMADA, nserv, res);
 	escribir_registro(0, res);
 	return;
 }
@@ -273,6 +697,7 @@ static void int_sw()
 {
 	// printk("[INT_SW()]\n");
 	// printk("\tTratando interrupción software\n");
+	TRAZAR(TRAZA_INTERRUPCIONES, TRAZA_INTERRUPCION, INT_SW, 0);
 
 	BCP *proceso_a_expulsar = p_proc_actual;
 	proceso_a_expulsar->ciclos_en_ejecucion = TICKS_POR_RODAJA;
@@ -282,16 +707,17 @@ static void int_sw()
 
 	eliminar_elem(&cola_listos, proceso_a_expulsar);
 	insertar_ultimo(&cola_listos, proceso_a_expulsar);
+	marcar_listo(proceso_a_expulsar, CAUSA_EXPULSION);
 
 	p_proc_actual = planificador();
 	p_proc_actual->ciclos_en_ejecucion = TICKS_POR_RODAJA;
 
-	insertar_ultimo(&cola_listos, proceso_a_expulsar);
-
 	// printk("\tEntra a ejecutarse el proceso %d\n", p_proc_actual->id);
 
-	fijar_nivel_int(nivel);
+	// Como en bloquear, el nivel se restaura al volver a ejecutar este proceso. sis_ceder_cpu
+	// llama aqui en NIVEL_1 y un tick antes del cambio expulsaria al proceso ya elegido
 	cambio_contexto(&(proceso_a_expulsar->contexto_regs), &(p_proc_actual->contexto_regs));
+	fijar_nivel_int(nivel);
 	return;
 }
 
@@ -318,21 +744,96 @@ static int crear_tarea(char *programa)
 						   &(p_proc->contexto_regs));
 		p_proc->id = proceso;
 		p_proc->estado = LISTO;
-		p_proc->ciclos_dormido = -1;
+		p_proc->lider = p_proc;
+		p_proc->num_hilos = 1;
+		p_proc->funcion_hilo = NULL;
+		p_proc->arg_hilo = NULL;
+		p_proc->tick_despertar = 0;
+		p_proc->grupo = (p_proc_actual != NULL) ? p_proc_actual->grupo : 0; // Se hereda el grupo del creador
+		memset(&(p_proc->estadisticas), 0, sizeof(estadisticas_proceso));
+		p_proc->ticks_situacion = NULL;
+		memset(p_proc->perfil_llamadas, 0, sizeof(p_proc->perfil_llamadas));
+		p_proc->estadisticas.creacion = leer_reloj_CMOS();
+		p_proc->tiempo_real = 0;
+		p_proc->plazos_perdidos = 0;
 		p_proc->ciclos_en_ejecucion = TICKS_POR_RODAJA;
+		p_proc->mutex_esperado = NULL;
+		p_proc->inicio_espera_mutex = 0;
+		p_proc->num_muestras = 0;
+		p_proc->muestras_perdidas = 0;
+		p_proc->ciclos_plazo = -1;
+		p_proc->plazo_vencido = 0;
+		p_proc->cola_espera = NULL;
+		for (int i = 0; i != NUM_MUT_PROC; ++i)
+		{
+			p_proc->descriptores_mutex[i] = NULL;
+		}
+		p_proc->descriptores_extra = NULL;
+		p_proc->num_descriptores = NUM_MUT_PROC;
+		for (int i = 0; i != NUM_SEGMENTOS; ++i)
+		{
+			p_proc->segmentos_abiertos[i] = 0;
+		}
 
-		insertar_ultimo(&cola_listos, p_proc);
+		insertar_listo(p_proc, CAUSA_NUEVO);
 		return 0;
 	}
 	else
 		return -1; // Fallo al crear imagen
 }
 
+static int crear_hilo(void *inicio, void *funcion, void *arg)
+{
+	int hilo = buscar_BCP_libre();
+	if (hilo == -1)
+	{
+		return -1; // No hay entrada libre
+	}
+
+	BCP *lider = p_proc_actual->lider;
+	BCP *p_hilo = &(tabla_procs[hilo]);
+
+	// El hilo ejecuta sobre la imagen de su proceso con una pila propia
+	p_hilo->info_mem = lider->info_mem;
+	p_hilo->pila = crear_pila(TAM_PILA);
+	fijar_contexto_ini(p_hilo->info_mem, p_hilo->pila, TAM_PILA,
+					   inicio,
+					   &(p_hilo->contexto_regs));
+	p_hilo->id = hilo;
+	p_hilo->estado = LISTO;
+	p_hilo->lider = lider;
+	p_hilo->num_hilos = 0;
+	p_hilo->funcion_hilo = funcion;
+	p_hilo->arg_hilo = arg;
+	p_hilo->tick_despertar = 0;
+	p_hilo->grupo = p_proc_actual->grupo;
+	memset(&(p_hilo->estadisticas), 0, sizeof(estadisticas_proceso));
+	p_hilo->ticks_situacion = NULL;
+	memset(p_hilo->perfil_llamadas, 0, sizeof(p_hilo->perfil_llamadas));
+	p_hilo->estadisticas.creacion = leer_reloj_CMOS();
+	p_hilo->tiempo_real = 0;
+	p_hilo->plazos_perdidos = 0;
+	p_hilo->ciclos_en_ejecucion = TICKS_POR_RODAJA;
+	p_hilo->mutex_esperado = NULL;
+	p_hilo->inicio_espera_mutex = 0;
+	p_hilo->num_muestras = 0;
+	p_hilo->muestras_perdidas = 0;
+	p_hilo->ciclos_plazo = -1;
+	p_hilo->plazo_vencido = 0;
+	p_hilo->cola_espera = NULL;
+	p_hilo->descriptores_extra = NULL;
+	p_hilo->num_descriptores = 0; // Se usan los descriptores del lider
+
+	lider->num_hilos++;
+	insertar_listo(p_hilo, CAUSA_NUEVO);
+	return hilo;
+}
+
 int sis_crear_proceso()
 {
-	printk("[SIS_CREAR_PROCESO()]\n");
+	DEPURAR("[SIS_CREAR_PROCESO()]\n");
 
-	printk("\tProceso %d. Creando proceso\n", p_proc_actual->id);
+	DEPURAR("\tProceso %d. Creando proceso\n", p_proc_actual->id);
 	char *prog = (char *)leer_registro(1);
 	return crear_tarea(prog);
 }
@@ -348,460 +849,2425 @@ int sis_escribir()
 
 int sis_terminar_proceso()
 {
-	printk("[SIS_TERMINAR_PROCESO()]\n");
-	printk("\tFin del proceso %d\n", p_proc_actual->id);
+	DEPURAR("[SIS_TERMINAR_PROCESO()]\n");
+	DEPURAR("\tFin del proceso %d\n", p_proc_actual->id);
 
 	liberar_proceso();
 	return 0; // No deberia llegar aqui
 }
 
-int sis_obtener_id_pr()
+int sis_crear_hilo()
 {
-	printk("[SIS_OBTENER_ID_PR()]\n");
+	DEPURAR("[SIS_CREAR_HILO()]\n");
 
-	int id_proceso_actual = p_proc_actual->id;
-	printk("ID del proceso actual: %d\n", id_proceso_actual);
-	return id_proceso_actual;
+	void *inicio = (void *)leer_registro(1);
+	void *funcion = (void *)leer_registro(2);
+	void *arg = (void *)leer_registro(3);
+
+	int hilo = crear_hilo(inicio, funcion, arg);
+	DEPURAR("\tEl proceso %d ha creado el hilo %d\n", p_proc_actual->lider->id, hilo);
+	return hilo;
 }
 
-int sis_dormir()
+int sis_datos_hilo()
 {
-	printk("[SIS_DORMIR()]\n");
-
-	int nivel = fijar_nivel_int(NIVEL_3);
-
-	unsigned int segundos = (unsigned int)leer_registro(1);
-	int ciclos = segundos * TICK;
-
-	printk("\tSegundos: %u\tCiclos: %d\n", segundos, ciclos);
-	printk("\tSe pone a dormir el proceso %d\n", p_proc_actual->id);
+	DEPURAR("[SIS_DATOS_HILO()]\n");
 
-	p_proc_actual->estado = BLOQUEADO;
-	p_proc_actual->ciclos_dormido = ciclos;
-	eliminar_elem(&cola_listos, p_proc_actual);
-	insertar_ultimo(&cola_bloqueados_dormir, p_proc_actual);
+	void **funcion = (void **)leer_registro(1);
+	void **arg = (void **)leer_registro(2);
 
-	BCP *proc_a_bloquear = p_proc_actual;
+	if (p_proc_actual->funcion_hilo == NULL)
+	{
+		DEPURAR("\tError: el proceso %d no es un hilo\n", p_proc_actual->id);
+		return -1;
+	}
+	*funcion = p_proc_actual->funcion_hilo;
+	*arg = p_proc_actual->arg_hilo;
+	return 0;
+}
 
-	p_proc_actual = planificador();
+int sis_ceder_cpu()
+{
+	DEPURAR("[SIS_CEDER_CPU()]\n");
 
+	int nivel = fijar_nivel_int(NIVEL_3);
+	int solo = (cola_listos.primero == cola_listos.ultimo);
 	fijar_nivel_int(nivel);
 
-	cambio_contexto(&(proc_a_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
+	if (solo)
+	{
+		// No hay otro proceso listo: sigue ejecutando con una rodaja nueva
+		p_proc_actual->ciclos_en_ejecucion = TICKS_POR_RODAJA;
+		return 0;
+	}
+
+	DEPURAR("\tEl proceso %d cede el procesador\n", p_proc_actual->id);
+	p_proc_actual->estadisticas.cambios_voluntarios++;
+	int_sw(); // Pasa al final de la cola de listos y reinicia su rodaja
 	return 0;
 }
 
-int sis_crear_mutex()
+int sis_obtener_estadisticas()
 {
-	printk("[SIS_CREAR_MUTEX()\n");
-
-	char *nombre_mutex = (char *)leer_registro(1);
-	int tipo_mutex = (int)leer_registro(2);
+	int id = (int)leer_registro(1);
+	estadisticas_proceso *buf = (estadisticas_proceso *)leer_registro(2);
 
-	char *tipo_str = (tipo_mutex == MUTEX_TIPO_RECURSIVO) ? "Recursivo" : "No recursivo";
-	printk("\tArg1 (Nombre): %s, Arg2 (Tipo): %d, %s\n", nombre_mutex, tipo_mutex, tipo_str);
-
-	int longitud_nombre = strlen(nombre_mutex) + 1;
-	if (longitud_nombre > MAX_NOM_MUT)
+	if (id == -1)
 	{
-		printk("\tError creando el mutex: la longitud del nombre argumento (%d) es superior al permitido (%d)", longitud_nombre, MAX_NOM_MUT);
+		id = p_proc_actual->id;
+	}
+	if (id < 0 || id >= MAX_PROC || tabla_procs[id].estado == NO_USADA || buf == NULL)
+	{
+		DEPURAR("\tError obteniendo estadisticas: el proceso %d no existe\n", id);
 		return -1;
 	}
 
-	if (buscar_nombre_mutex(nombre_mutex) >= 0)
-	{
-		printk("\tError creando el mutex: ya existe un mutex con ese nombre\n");
+	int nivel = fijar_nivel_int(NIVEL_3); // Copia coherente con int_reloj
+	cargar_ticks(&(tabla_procs[id])); // Los ticks de la situacion actual aun no se han cargado
+	*buf = tabla_procs[id].estadisticas;
+	buf->id = id;
+	buf->estado = tabla_procs[id].estado;
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+int sis_obtener_instantanea()
+{
+	instantanea *inst = (instantanea *)leer_registro(1);
+	instantanea_proceso *procesos = (instantanea_proceso *)leer_registro(2);
+	int max_procesos = (int)leer_registro(3);
+	instantanea_mutex *mutexes = (instantanea_mutex *)leer_registro(4);
+	int max_mutex = (int)leer_registro(5);
+
+	if (inst == NULL || (procesos == NULL && max_procesos > 0) || (mutexes == NULL && max_mutex > 0))
+	{
+		return -1;
+	}
+
+	// Se copia todo sin permitir interrupciones para que la instantanea sea coherente
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	inst->ticks = ticks_sistema;
+	inst->proceso_actual = p_proc_actual->id;
+
+	inst->num_procesos = 0;
+	for (int i = 0; i != MAX_PROC && inst->num_procesos < max_procesos; ++i)
+	{
+		BCP *p_proc = &(tabla_procs[i]);
+		if (p_proc->estado == NO_USADA)
+		{
+			continue;
+		}
+		instantanea_proceso *ip = &(procesos[inst->num_procesos++]);
+		ip->id = p_proc->id;
+		ip->estado = p_proc->estado;
+		ip->cola = -1; // Terminado o zombi: no esta en ninguna cola
+		if (p_proc->estado == LISTO)
+		{
+			ip->cola = COLA_LISTOS;
+		}
+		else if (p_proc->estado == BLOQUEADO)
+		{
+			ip->cola = identificar_cola(p_proc->cola_espera);
+		}
+		ip->lider = p_proc->lider->id;
+		ip->grupo = p_proc->grupo;
+		ip->tiempo_real = p_proc->tiempo_real;
+		if (ip->cola == COLA_DORMIR)
+		{
+			ip->ticks_restantes = p_proc->tick_despertar - ticks_sistema;
+		}
+		else
+		{
+			ip->ticks_restantes = (p_proc->estado == BLOQUEADO && p_proc->ciclos_plazo >= 0) ? p_proc->tick_plazo - ticks_sistema : -1;
+		}
+		ip->mutex_esperado = (p_proc->mutex_esperado != NULL) ? p_proc->mutex_esperado->mutex_id : -1;
+	}
+
+	lista_BCPs *colas[NUM_COLAS_SISTEMA] = {&cola_listos, &cola_bloqueados_dormir, &cola_bloqueados_mutex_libre,
+											 &cola_bloqueados_mutex_lock, &cola_bloqueados_terminal, &cola_bloqueados_plazo,
+											 &cola_tiempo_real_agotados, &cola_grupos_aparcados};
+	for (int c = 0; c != NUM_COLAS_SISTEMA; ++c)
+	{
+		inst->longitud_colas[c] = 0;
+		for (BCP *p_proc = colas[c]->primero; p_proc != NULL; p_proc = p_proc->siguiente)
+		{
+			inst->longitud_colas[c]++;
+		}
+	}
+
+	inst->num_mutex = 0;
+	for (int i = 0; i != num_bloques_mutex * NUM_MUT && inst->num_mutex < max_mutex; ++i)
+	{
+		mutex *mut = obtener_mutex(i);
+		if (mut->estado == MUTEX_ESTADO_LIBRE)
+		{
+			continue;
+		}
+		instantanea_mutex *im = &(mutexes[inst->num_mutex++]);
+		strncpy(im->nombre, mut->nombre, MAX_NOM_MUT);
+		im->id = mut->mutex_id;
+		im->estado = mut->estado;
+		im->tipo = mut->tipo;
+		im->politica = mut->politica;
+		im->propietario = mut->id_proc_bloq;
+		im->num_locks = mut->num_locks;
+		im->bloqueados = mut->num_procesos_bloqueados;
+		im->aperturas = mut->num_aperturas;
+	}
+
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+static int identificar_cola(lista_BCPs *cola)
+{
+	if (cola == &cola_listos)
+		return COLA_LISTOS;
+	if (cola == &cola_bloqueados_dormir)
+		return COLA_DORMIR;
+	if (cola == &cola_bloqueados_mutex_libre)
+		return COLA_MUTEX_LIBRE;
+	if (cola == &cola_bloqueados_mutex_lock)
+		return COLA_MUTEX_LOCK;
+	if (cola == &cola_bloqueados_terminal)
+		return COLA_TERMINAL;
+	if (cola == &cola_bloqueados_plazo)
+		return COLA_PLAZO;
+	if (cola == &cola_tiempo_real_agotados)
+		return COLA_TIEMPO_REAL_AGOTADOS;
+	if (cola == &cola_grupos_aparcados)
+		return COLA_GRUPOS_APARCADOS;
+	return COLA_OTRA; // Colas de mensajes
+}
+
+int sis_obtener_perfil_mutex()
+{
+	int id = (int)leer_registro(1);
+	perfil_mutex *buf = (perfil_mutex *)leer_registro(2);
+
+	if (id < 0 || id >= num_bloques_mutex * NUM_MUT || buf == NULL)
+	{
+		return -1;
+	}
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	*buf = obtener_mutex(id)->perfil;
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+int sis_fijar_mascara_traza()
+{
+	int mascara = (int)leer_registro(1);
+
+	int anterior = mascara_traza;
+	mascara_traza = mascara & TRAZA_TODAS;
+	return anterior;
+}
+
+int sis_leer_traza()
+{
+	evento_traza *eventos = (evento_traza *)leer_registro(1);
+	int max_eventos = (int)leer_registro(2);
+	estado_traza *estado = (estado_traza *)leer_registro(3);
+
+	if ((eventos == NULL && max_eventos > 0) || max_eventos < 0)
+	{
+		return -1;
+	}
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	// Se copian los ultimos eventos que sigan en el buffer, del mas antiguo al mas reciente
+	unsigned int total = traza_siguiente;
+	unsigned int disponibles = (total < TAM_TRAZA) ? total : TAM_TRAZA;
+	unsigned int num = ((unsigned int)max_eventos < disponibles) ? (unsigned int)max_eventos : disponibles;
+	for (unsigned int i = 0; i != num; ++i)
+	{
+		eventos[i] = traza[(total - num + i) % TAM_TRAZA];
+	}
+
+	if (estado != NULL)
+	{
+		estado->mascara = mascara_traza;
+		estado->eventos = total;
+		estado->ciclos_inicio = ciclos_arranque;
+		estado->ciclos_por_ms = ciclos_por_ms;
+	}
+
+	fijar_nivel_int(nivel);
+	return (int)num;
+}
+
+int sis_obtener_perfil_llamada()
+{
+	int servicio = (int)leer_registro(1);
+	int id = (int)leer_registro(2);
+	perfil_llamada *buf = (perfil_llamada *)leer_registro(3);
+
+	if (!PERFIL_LLAMADAS || servicio < 0 || servicio >= NSERVICIOS || buf == NULL)
+	{
+		return -1; // Sin PERFIL_LLAMADAS no se mide nada
+	}
+
+	perfil_llamada *perfil = NULL;
+	if (id == PERFIL_SISTEMA)
+	{
+		perfil = &(perfil_llamadas[servicio]);
+	}
+	else if (id == -1)
+	{
+		perfil = &(p_proc_actual->perfil_llamadas[servicio]);
+	}
+	else
+	{
+		for (int i = 0; i != MAX_PROC; ++i)
+		{
+			if (tabla_procs[i].estado != NO_USADA && tabla_procs[i].id == id)
+			{
+				perfil = &(tabla_procs[i].perfil_llamadas[servicio]);
+			}
+		}
+	}
+	if (perfil == NULL)
+	{
+		return -1;
+	}
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	*buf = *perfil;
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+int sis_fijar_muestreo()
+{
+	int periodo = (int)leer_registro(1);
+
+	if (periodo < 0)
+	{
+		return -1;
+	}
+	int anterior = periodo_muestreo;
+	periodo_muestreo = periodo;
+	return anterior;
+}
+
+int sis_leer_muestras()
+{
+	int id = (int)leer_registro(1);
+	void **pcs = (void **)leer_registro(2);
+	int max_muestras = (int)leer_registro(3);
+	int *perdidas = (int *)leer_registro(4);
+
+	BCP *proceso = (id == -1) ? p_proc_actual : NULL;
+	for (int i = 0; i != MAX_PROC && proceso == NULL; ++i)
+	{
+		if (tabla_procs[i].estado != NO_USADA && tabla_procs[i].id == id)
+		{
+			proceso = &(tabla_procs[i]);
+		}
+	}
+	if (proceso == NULL || max_muestras < 0 || (pcs == NULL && max_muestras > 0))
+	{
+		return -1;
+	}
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	int num = (max_muestras < proceso->num_muestras) ? max_muestras : proceso->num_muestras;
+	memcpy(pcs, proceso->muestras, num * sizeof(void *));
+	if (perdidas != NULL)
+	{
+		*perdidas = proceso->muestras_perdidas + (proceso->num_muestras - num);
+	}
+	fijar_nivel_int(nivel);
+	return num;
+}
+
+int sis_resolver_direccion()
+{
+	void *pc = (void *)leer_registro(1);
+	char *nombre = (char *)leer_registro(2);
+	int tam = (int)leer_registro(3);
+
+	// Las imagenes son bibliotecas dinamicas cargadas en el mismo espacio: se usan sus simbolos exportados
+	Dl_info info;
+	if (nombre == NULL || tam <= 0 || dladdr(pc, &info) == 0)
+	{
+		return -1;
+	}
+
+	char *imagen = (info.dli_fname != NULL) ? strrchr(info.dli_fname, '/') : NULL;
+	imagen = (imagen != NULL) ? imagen + 1 : (char *)info.dli_fname;
+	snprintf(nombre, tam, "%s (%s)", (info.dli_sname != NULL) ? info.dli_sname : "??", (imagen != NULL) ? imagen : "??");
+	return 0;
+}
+
+int sis_obtener_latencias()
+{
+	latencias_planificacion *buf = (latencias_planificacion *)leer_registro(1);
+	int reiniciar = (int)leer_registro(2);
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if (buf != NULL)
+	{
+		*buf = latencias;
+	}
+	if (reiniciar)
+	{
+		memset(&latencias, 0, sizeof(latencias));
+	}
+	fijar_nivel_int(nivel);
+	return ticks_sistema; // Permite situar historial_listos en el tiempo
+}
+
+int sis_obtener_tiempo()
+{
+	int *ticks = (int *)leer_registro(1);
+	unsigned long long *ns = (unsigned long long *)leer_registro(2);
+
+	if (ticks != NULL)
+	{
+		*ticks = ticks_sistema;
+	}
+	if (ns != NULL)
+	{
+		*ns = ns_desde_arranque();
+	}
+	return 0;
+}
+
+int sis_obtener_estadisticas_terminal()
+{
+	estadisticas_terminal *buf = (estadisticas_terminal *)leer_registro(1);
+	int reiniciar = (int)leer_registro(2);
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if (buf != NULL)
+	{
+		*buf = estadisticas_term;
+	}
+	if (reiniciar)
+	{
+		memset(&estadisticas_term, 0, sizeof(estadisticas_term));
+	}
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+int sis_obtener_pagina_tiempo()
+{
+	const pagina_tiempo **dir = (const pagina_tiempo **)leer_registro(1);
+
+	if (dir == NULL)
+	{
+		return -1;
+	}
+	*dir = tiempo_compartido_usuario;
+	return 0;
+}
+
+int sis_obtener_id_pr()
+{
+	DEPURAR("[SIS_OBTENER_ID_PR()]\n");
+
+	int id_proceso_actual = p_proc_actual->id;
+	DEPURAR("ID del proceso actual: %d\n", id_proceso_actual);
+	return id_proceso_actual;
+}
+
+int sis_dormir()
+{
+	DEPURAR("[SIS_DORMIR()]\n");
+
+	unsigned int segundos = (unsigned int)leer_registro(1);
+	int ciclos = segundos * TICK;
+
+	DEPURAR("\tSegundos: %u\tCiclos: %d\n", segundos, ciclos);
+	DEPURAR("\tSe pone a dormir el proceso %d\n", p_proc_actual->id);
+
+	dormir_hasta(ticks_sistema + ciclos);
+	return 0;
+}
+
+int sis_dormir_ticks()
+{
+	int ticks = (int)leer_registro(1);
+
+	dormir_hasta(ticks_sistema + ticks);
+	return 0;
+}
+
+int sis_dormir_ms()
+{
+	int ms = (int)leer_registro(1);
+
+	if (ms < 0)
+	{
+		DEPURAR("\tError: tiempo negativo\n");
+		return -1;
+	}
+
+	// Se redondea hacia arriba para no despertar antes de tiempo. En int, ms * TICK se desborda
+	// a partir de unos 21 millones de ms; el resultado siempre cabe
+	dormir_hasta(ticks_sistema + (int)(((long long)ms * TICK + 999) / 1000));
+	return 0;
+}
+
+int sis_dormir_hasta()
+{
+	int tick = (int)leer_registro(1);
+
+	dormir_hasta(tick);
+	return 0;
+}
+
+static void dormir_hasta(int tick)
+{
+	// Las comparaciones de ticks se hacen con la diferencia para tolerar el desbordamiento del contador
+	if (tick - ticks_sistema <= 0)
+	{
+		return;
+	}
+
+	p_proc_actual->tick_despertar = tick;
+	bloquear(&cola_bloqueados_dormir, -1);
+}
+
+// Grupos con cuota de procesador
+int sis_fijar_grupo()
+{
+	DEPURAR("[SIS_FIJAR_GRUPO()]\n");
+
+	int id_grupo = (int)leer_registro(1);
+
+	if (id_grupo < 0 || id_grupo >= NUM_GRUPOS)
+	{
+		DEPURAR("\tError: el grupo %d no existe\n", id_grupo);
+		return -1;
+	}
+
+	// El cambio se aplica en el siguiente tick aunque el nuevo grupo haya agotado su cuota
+	p_proc_actual->grupo = id_grupo;
+	return 0;
+}
+
+int sis_fijar_cuota()
+{
+	DEPURAR("[SIS_FIJAR_CUOTA()]\n");
+
+	int id_grupo = (int)leer_registro(1);
+	int cuota = (int)leer_registro(2);
+
+	DEPURAR("\tArg1 (Grupo): %d, Arg2 (Cuota): %d\n", id_grupo, cuota);
+
+	if (id_grupo < 0 || id_grupo >= NUM_GRUPOS || cuota < 0 || cuota > VENTANA_CUOTA)
+	{
+		DEPURAR("\tError: grupo o cuota no validos\n");
+		return -1;
+	}
+
+	tabla_grupos[id_grupo].cuota = cuota;
+	return 0;
+}
+
+static int grupo_agotado(int id_grupo)
+{
+	grupo *g = &(tabla_grupos[id_grupo]);
+	return g->cuota > 0 && g->consumidos >= g->cuota;
+}
+
+static void aparcar_grupo(int id_grupo)
+{
+	// Saca de la cola de listos a los demas procesos normales del grupo. El actual lo aparca quien llama
+	BCP *p_proc = cola_listos.primero;
+	while (p_proc != NULL)
+	{
+		BCP *p_proximo = p_proc->siguiente;
+		if (p_proc != p_proc_actual && !p_proc->tiempo_real && p_proc->grupo == id_grupo)
+		{
+			eliminar_elem(&cola_listos, p_proc);
+			p_proc->estado = BLOQUEADO;
+			p_proc->cola_espera = &cola_grupos_aparcados;
+			insertar_ultimo(&cola_grupos_aparcados, p_proc);
+			contabilizar(p_proc, 0);
+		}
+		p_proc = p_proximo;
+	}
+}
+
+static void nueva_ventana()
+{
+	while (ticks_sistema - inicio_ventana >= VENTANA_CUOTA)
+	{
+		inicio_ventana += VENTANA_CUOTA;
+	}
+	for (int i = 0; i != NUM_GRUPOS; ++i)
+	{
+		tabla_grupos[i].consumidos = 0;
+	}
+
+	// Todos los grupos vuelven a tener cuota
+	while (cola_grupos_aparcados.primero != NULL)
+	{
+		BCP *p_proc = cola_grupos_aparcados.primero;
+		eliminar_primero(&cola_grupos_aparcados);
+		p_proc->estado = LISTO;
+		p_proc->cola_espera = NULL;
+		if (p_proc->instante_listo == 0)
+		{
+			marcar_listo(p_proc, CAUSA_CUOTA); // Si ya estaba listo cuando se aparco, su espera cuenta desde entonces
+		}
+		insertar_ultimo(&cola_listos, p_proc);
+		contabilizar(p_proc, 0);
+	}
+}
+
+static void iniciar_grupos()
+{
+	for (int i = 0; i != NUM_GRUPOS; ++i)
+	{
+		tabla_grupos[i].cuota = 0; // Sin limite
+		tabla_grupos[i].consumidos = 0;
+	}
+}
+
+// Planificacion de tiempo real
+int sis_fijar_tiempo_real()
+{
+	DEPURAR("[SIS_FIJAR_TIEMPO_REAL()]\n");
+
+	int periodo = (int)leer_registro(1);
+	int presupuesto = (int)leer_registro(2);
+
+	DEPURAR("\tArg1 (Periodo): %d, Arg2 (Presupuesto): %d\n", periodo, presupuesto);
+
+	int utilizacion_propia = p_proc_actual->tiempo_real ? p_proc_actual->utilizacion : 0;
+
+	if (periodo == 0)
+	{
+		// Vuelve a la clase normal
+		salir_tiempo_real(p_proc_actual);
+		return 0;
+	}
+
+	if (periodo < 0 || presupuesto <= 0 || presupuesto > periodo)
+	{
+		DEPURAR("\tError: periodo o presupuesto no validos\n");
+		return -1;
+	}
+
+	// Control de admision: la utilizacion total (en milesimas) no puede superar el limite
+	int utilizacion = (presupuesto * 1000 + periodo - 1) / periodo;
+	if (utilizacion_tiempo_real - utilizacion_propia + utilizacion > UTILIZACION_MAX_TIEMPO_REAL)
+	{
+		DEPURAR("\tSe rechaza la tarea: la utilizacion seria %d/1000\n", utilizacion_tiempo_real - utilizacion_propia + utilizacion);
+		return -2;
+	}
+	utilizacion_tiempo_real += utilizacion - utilizacion_propia;
+
+	int era_tiempo_real = p_proc_actual->tiempo_real;
+	p_proc_actual->tiempo_real = 1;
+	p_proc_actual->periodo = periodo;
+	p_proc_actual->presupuesto = presupuesto;
+	p_proc_actual->presupuesto_restante = presupuesto;
+	p_proc_actual->utilizacion = utilizacion;
+	p_proc_actual->plazo = ticks_sistema + periodo;
+	p_proc_actual->periodo_terminado = 0;
+
+	// El tick recorre la lista para empezar los periodos: la tarea se anade con el plazo ya fijado
+	if (!era_tiempo_real)
+	{
+		p_proc_actual->siguiente_tiempo_real = lista_tiempo_real;
+		lista_tiempo_real = p_proc_actual;
+	}
+	DEPURAR("\tEl proceso %d es de tiempo real. Utilizacion total: %d/1000\n", p_proc_actual->id, utilizacion_tiempo_real);
+	return 0;
+}
+
+int sis_esperar_periodo()
+{
+	if (!p_proc_actual->tiempo_real)
+	{
+		return -1;
+	}
+
+	// El trabajo del periodo ha terminado: se espera al comienzo del siguiente
+	p_proc_actual->periodo_terminado = 1;
+	dormir_hasta(p_proc_actual->plazo);
+	return 0;
+}
+
+int sis_plazos_perdidos()
+{
+	return p_proc_actual->plazos_perdidos;
+}
+
+// Temporizadores periodicos
+int sis_crear_temporizador()
+{
+	DEPURAR("[SIS_CREAR_TEMPORIZADOR()]\n");
+
+	int periodo = (int)leer_registro(1);
+
+	DEPURAR("\tArg1 (Periodo): %d\n", periodo);
+
+	if (periodo <= 0)
+	{
+		DEPURAR("\tError creando el temporizador: periodo no valido\n");
+		return -1;
+	}
+
+	for (int i = 0; i != NUM_TEMPORIZADORES; ++i)
+	{
+		temporizador *temp = &(tabla_temporizadores[i]);
+		if (!temp->usado)
+		{
+			temp->usado = 1;
+			temp->propietario = p_proc_actual->lider->id;
+			temp->periodo = periodo;
+			temp->proximo = ticks_sistema + periodo;
+			return i;
+		}
+	}
+
+	DEPURAR("\tError creando el temporizador: no hay temporizadores libres\n");
+	return -2;
+}
+
+int sis_esperar_temporizador()
+{
+	unsigned int id_temp = (unsigned int)leer_registro(1);
+
+	temporizador *temp = obtener_temporizador(id_temp);
+	if (temp == NULL)
+	{
+		DEPURAR("\tError esperando el temporizador %u: no existe\n", id_temp);
+		return -1;
+	}
+
+	dormir_hasta(temp->proximo);
+
+	// Los vencimientos se calculan desde el anterior, no desde el despertar, para no acumular deriva.
+	// Si el proceso llega tarde se cuentan todos los periodos vencidos
+	int vencimientos = 0;
+	while (temp->proximo - ticks_sistema <= 0)
+	{
+		temp->proximo += temp->periodo;
+		vencimientos++;
+	}
+	return vencimientos;
+}
+
+int sis_destruir_temporizador()
+{
+	unsigned int id_temp = (unsigned int)leer_registro(1);
+
+	temporizador *temp = obtener_temporizador(id_temp);
+	if (temp == NULL)
+	{
+		return -1;
+	}
+	temp->usado = 0;
+	return 0;
+}
+
+static void iniciar_temporizadores()
+{
+	for (int i = 0; i != NUM_TEMPORIZADORES; ++i)
+	{
+		tabla_temporizadores[i].usado = 0;
+	}
+}
+
+static temporizador *obtener_temporizador(unsigned int id_temp)
+{
+	if (id_temp >= NUM_TEMPORIZADORES || !tabla_temporizadores[id_temp].usado ||
+		tabla_temporizadores[id_temp].propietario != p_proc_actual->lider->id)
+	{
+		return NULL;
+	}
+	return &(tabla_temporizadores[id_temp]);
+}
+
+static void liberar_temporizadores()
+{
+	for (int i = 0; i != NUM_TEMPORIZADORES; ++i)
+	{
+		if (tabla_temporizadores[i].usado && tabla_temporizadores[i].propietario == p_proc_actual->lider->id)
+		{
+			tabla_temporizadores[i].usado = 0;
+		}
+	}
+}
+
+int sis_crear_mutex()
+{
+	DEPURAR("[SIS_CREAR_MUTEX()\n");
+
+	char *nombre_mutex = (char *)leer_registro(1);
+	int tipo_mutex = (int)leer_registro(2);
+
+	char *tipo_str = (tipo_mutex == MUTEX_TIPO_RECURSIVO) ? "Recursivo" : "No recursivo";
+	DEPURAR("\tArg1 (Nombre): %s, Arg2 (Tipo): %d, %s\n", nombre_mutex, tipo_mutex, tipo_str);
+
+	int longitud_nombre = strlen(nombre_mutex) + 1;
+	if (longitud_nombre > MAX_NOM_MUT)
+	{
+		DEPURAR("\tError creando el mutex: la longitud del nombre argumento (%d) es superior al permitido (%d)", longitud_nombre, MAX_NOM_MUT);
+		return -1;
+	}
+
+	if (buscar_nombre_mutex(nombre_mutex) >= 0)
+	{
+		DEPURAR("\tError creando el mutex: ya existe un mutex con ese nombre\n");
+		return -2;
+	}
+
+	int descriptor = buscar_descriptor_libre();
+	if (descriptor < 0)
+	{
+		DEPURAR("\tError creando el mutex: no hay descriptores disponibles\n");
+		return -3;
+	}
+
+	int mutex_id = buscar_mutex_libre();
+	while (mutex_id < 0)
+	{
+		DEPURAR("\tNo hay mutex disponibles en el sistema. Se va a bloquear el proceso hasta que se libere alguno\n");
+		bloquear(&cola_bloqueados_mutex_libre, -1);
+
+		// Mientras estaba bloqueado otro proceso ha podido crear un mutex con el mismo nombre
+		if (buscar_nombre_mutex(nombre_mutex) >= 0)
+		{
+			DEPURAR("\tError creando el mutex: ya existe un mutex con ese nombre\n");
+			despertar_creador_mutex(); // El mutex libre queda para el siguiente proceso que espera
+			return -2;
+		}
+		mutex_id = buscar_mutex_libre();
+
+		// Los hilos del mismo proceso comparten descriptores: alguno ha podido ocupar el elegido
+		descriptor = buscar_descriptor_libre();
+		if (descriptor < 0)
+		{
+			DEPURAR("\tError creando el mutex: no hay descriptores disponibles\n");
+			if (mutex_id >= 0)
+			{
+				despertar_creador_mutex();
+			}
+			return -3;
+		}
+	}
+
+	mutex *nuevo_mutex = obtener_mutex(mutex_id);
+
+	strcpy(nuevo_mutex->nombre, nombre_mutex);
+	nuevo_mutex->estado = MUTEX_ESTADO_CREADO;
+	nuevo_mutex->tipo = tipo_mutex;
+	nuevo_mutex->num_locks = 0;
+	nuevo_mutex->num_procesos_bloqueados = 0;
+	nuevo_mutex->id_proc_bloq = -1;
+	nuevo_mutex->politica = MUTEX_POLITICA_FIFO;
+	nuevo_mutex->num_aperturas = 1;
+	strcpy(nuevo_mutex->perfil.nombre, nombre_mutex);
+
+	fijar_descriptor(p_proc_actual, descriptor, nuevo_mutex);
+
+	DEPURAR("\tSe ha creado el mutex %s con el descriptor %d\n", nombre_mutex, descriptor);
+	return descriptor;
+}
+
+int sis_abrir_mutex()
+{
+	DEPURAR("[SIS_ABRIR_MUTEX()]\n");
+
+	char *nombre_mutex = (char *)leer_registro(1);
+	DEPURAR("\tArg1 (Nombre): %s\n", nombre_mutex);
+
+	int mutex_id = buscar_nombre_mutex(nombre_mutex);
+	if (mutex_id < 0)
+	{
+		DEPURAR("\tError abriendo el mutex: no existe ningún mutex llamado %s\n", nombre_mutex);
+		return -1;
+	}
+
+	int descriptor = buscar_descriptor_libre();
+	if (descriptor < 0)
+	{
+		DEPURAR("\tError abriendo el mutex: se ha alcanzado el límite de mutex por proceso\n", nombre_mutex, descriptor);
+		return -2;
+	}
+
+	DEPURAR("\tSe ha abierto el mutex %s. Descriptor: %d\n", nombre_mutex, descriptor);
+	fijar_descriptor(p_proc_actual, descriptor, obtener_mutex(mutex_id));
+	obtener_mutex(mutex_id)->num_aperturas++;
+	return descriptor;
+}
+
+int sis_lock_mutex()
+{
+	DEPURAR("[SIS_LOCK_MUTEX()]\n");
+
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	DEPURAR("\tArg1 (Descriptor): %u\n", descriptor);
+
+	return adquirir_mutex(descriptor, -1);
+}
+
+int sis_trylock_mutex()
+{
+	DEPURAR("[SIS_TRYLOCK_MUTEX()]\n");
+
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	DEPURAR("\tArg1 (Descriptor): %u\n", descriptor);
+
+	return adquirir_mutex(descriptor, 0);
+}
+
+int sis_lock_timeout_mutex()
+{
+	DEPURAR("[SIS_LOCK_TIMEOUT_MUTEX()]\n");
+
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+	int ciclos = (int)leer_registro(2);
+
+	DEPURAR("\tArg1 (Descriptor): %u, Arg2 (Ciclos): %d\n", descriptor, ciclos);
+
+	if (ciclos < 0)
+	{
+		DEPURAR("\tError en lock: el plazo no puede ser negativo\n");
+		return -4;
+	}
+
+	return adquirir_mutex(descriptor, ciclos);
+}
+
+int sis_unlock_mutex()
+{
+	DEPURAR("[SIS_UNLOCK_MUTEX()]\n");
+
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	DEPURAR("\tArg1 (Descriptor): %u\n", descriptor);
+
+	mutex *mutex_unlock = obtener_descriptor(p_proc_actual, descriptor);
+
+	if (mutex_unlock == NULL)
+	{
+		DEPURAR("\tError en unlock: el mutex con descriptor %u no existe\n", descriptor);
+		return -1;
+	}
+
+	if (mutex_unlock->estado != MUTEX_ESTADO_BLOQUEADO)
+	{
+		DEPURAR("\tError en unlock: el mutex %s no está bloqueado\n", mutex_unlock->nombre);
+		return -2;
+	}
+
+	if (mutex_unlock->id_proc_bloq != p_proc_actual->id)
+	{
+		DEPURAR("\tError en unlock: el proceso %d no puede hacer unlock sobre el mutex %s. Debe hacerlo %d\n",
+			   p_proc_actual->id, mutex_unlock->nombre, mutex_unlock->id_proc_bloq);
+		return -3;
+	}
+
+	switch (mutex_unlock->tipo)
+	{
+	case MUTEX_TIPO_NO_RECURSIVO:
+		break;
+	case MUTEX_TIPO_RECURSIVO:
+		mutex_unlock->num_locks--;
+		DEPURAR("\tHace falta realizar unlock sobre el mutex recursivo %s %d veces mas\n", mutex_unlock->nombre, mutex_unlock->num_locks);
+		break;
+	default:
+		DEPURAR("\tError con el mutex %s: el valor de TIPO es extraño (%d)\n", mutex_unlock->nombre, mutex_unlock->tipo);
+		break;
+	}
+
+	if (mutex_unlock->num_locks == 0)
+	{
+		unlock(descriptor, mutex_unlock);
+	}
+	DEPURAR("\tSe ha realizado unlock sobre el mutex %s\n", mutex_unlock->nombre);
+	return 0;
+}
+
+int sis_cerrar_mutex()
+{
+	DEPURAR("[SIS_CERRAR_MUTEX()]\n");
+
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	DEPURAR("\tArg1 (Descriptor): %u\n", descriptor);
+
+	mutex *mutex_cerrar = obtener_descriptor(p_proc_actual, descriptor);
+
+	if (mutex_cerrar == NULL)
+	{
+		DEPURAR("\tError cerrando el mutex: no existe el mutex con descriptor %u\n", descriptor);
+		return -1;
+	}
+
+	// Los hilos comparten el descriptor: cerrarlo ahora dejaria sin mutex al que lo usa
+	if (usado_por_otro_hilo(mutex_cerrar))
+	{
+		DEPURAR("\tError cerrando el mutex: otro hilo del proceso %d lo posee o espera por el\n", p_proc_actual->lider->id);
+		return -2;
+	}
+
+	cerrar(descriptor, mutex_cerrar);
+	return 0;
+}
+
+int sis_politica_mutex()
+{
+	DEPURAR("[SIS_POLITICA_MUTEX()]\n");
+
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+	int politica = (int)leer_registro(2);
+
+	DEPURAR("\tArg1 (Descriptor): %u, Arg2 (Politica): %d\n", descriptor, politica);
+
+	mutex *mutex_politica = obtener_descriptor(p_proc_actual, descriptor);
+
+	if (mutex_politica == NULL)
+	{
+		DEPURAR("\tError fijando la politica: no existe el mutex con descriptor %u\n", descriptor);
+		return -1;
+	}
+
+	if (politica != MUTEX_POLITICA_FIFO && politica != MUTEX_POLITICA_COMPETITIVA)
+	{
+		DEPURAR("\tError fijando la politica: el valor de POLITICA es extraño (%d)\n", politica);
+		return -2;
+	}
+
+	mutex_politica->politica = politica;
+	return 0;
+}
+
+static void iniciar_tabla_mutex()
+{
+	num_bloques_mutex = 0;
+	if (ampliar_tabla_mutex() < 0)
+	{
+		panico("No hay memoria para la tabla de mutex");
+	}
+}
+
+static int ampliar_tabla_mutex()
+{
+	if (num_bloques_mutex == MAX_MUT / NUM_MUT)
+	{
+		DEPURAR("\tLa tabla de mutex ha alcanzado su tamaño maximo (%d)\n", MAX_MUT);
+		return -1;
+	}
+
+	mutex *bloque = malloc(NUM_MUT * sizeof(mutex));
+	if (bloque == NULL)
+	{
+		DEPURAR("\tNo hay memoria para ampliar la tabla de mutex\n");
+		return -1;
+	}
+
+	for (int i = 0; i != NUM_MUT; ++i)
+	{
+		bloque[i].nombre[0] = '\0'; // "NO MUTEX" no cabe en MAX_NOM_MUT
+		bloque[i].mutex_id = num_bloques_mutex * NUM_MUT + i;
+		bloque[i].estado = MUTEX_ESTADO_LIBRE;
+		bloque[i].num_locks = 0;
+		bloque[i].num_procesos_bloqueados = 0;
+		bloque[i].id_proc_bloq = -1;
+		bloque[i].politica = MUTEX_POLITICA_FIFO;
+		bloque[i].num_aperturas = 0;
+		memset(&(bloque[i].perfil), 0, sizeof(perfil_mutex));
+	}
+	tabla_mutex[num_bloques_mutex] = bloque;
+	num_bloques_mutex++;
+
+	DEPURAR("\tLa tabla de mutex tiene ahora %d mutex\n", num_bloques_mutex * NUM_MUT);
+	return 0;
+}
+
+static mutex *obtener_mutex(int mutex_id)
+{
+	return &(tabla_mutex[mutex_id / NUM_MUT][mutex_id % NUM_MUT]);
+}
+
+static mutex *obtener_descriptor(BCP *proceso, unsigned int descriptor)
+{
+	proceso = proceso->lider; // Los hilos comparten los descriptores de su proceso
+	if (descriptor < NUM_MUT_PROC)
+	{
+		return proceso->descriptores_mutex[descriptor];
+	}
+	if (descriptor < proceso->num_descriptores)
+	{
+		return proceso->descriptores_extra[descriptor - NUM_MUT_PROC];
+	}
+	return NULL; // Descriptor fuera de la tabla
+}
+
+static void fijar_descriptor(BCP *proceso, unsigned int descriptor, mutex *mut)
+{
+	proceso = proceso->lider;
+	if (descriptor < NUM_MUT_PROC)
+	{
+		proceso->descriptores_mutex[descriptor] = mut;
+	}
+	else
+	{
+		proceso->descriptores_extra[descriptor - NUM_MUT_PROC] = mut;
+	}
+}
+
+static int buscar_descriptor_libre()
+{
+	BCP *proceso = p_proc_actual->lider;
+	for (int i = 0; i != proceso->num_descriptores; ++i)
+	{
+		if (obtener_descriptor(proceso, i) == NULL)
+		{
+			return i; // Devuelve el numero del descriptor
+		}
+	}
+
+	// No hay descriptor libre: se duplica la parte dinamica de la tabla de descriptores
+	int num_descriptores = proceso->num_descriptores * 2;
+	if (num_descriptores > MAX_MUT_PROC)
+	{
+		num_descriptores = MAX_MUT_PROC;
+	}
+	if (num_descriptores == proceso->num_descriptores)
+	{
+		return -1; // Se ha alcanzado el maximo de descriptores
+	}
+
+	mutex **descriptores_extra = realloc(proceso->descriptores_extra,
+										 (num_descriptores - NUM_MUT_PROC) * sizeof(mutex *));
+	if (descriptores_extra == NULL)
+	{
+		return -1; // No hay memoria
+	}
+
+	int descriptor = proceso->num_descriptores;
+	proceso->descriptores_extra = descriptores_extra;
+	proceso->num_descriptores = num_descriptores;
+	for (int i = descriptor; i != num_descriptores; ++i)
+	{
+		fijar_descriptor(proceso, i, NULL);
+	}
+	DEPURAR("\tEl proceso %d tiene ahora %d descriptores de mutex\n", proceso->id, num_descriptores);
+	return descriptor;
+}
+
+static int buscar_nombre_mutex(char *nombre_mutex)
+{
+	for (int i = 0; i != num_bloques_mutex * NUM_MUT; ++i)
+	{
+		mutex *mut = obtener_mutex(i);
+		if (mut->estado != MUTEX_ESTADO_LIBRE && strcmp(mut->nombre, nombre_mutex) == 0)
+		{
+			return i; // El nombre existe y devuelve su posicion (descriptor) en la tabla de mutex
+		}
+	}
+	return -1; // El nombre no existe
+}
+
+static int buscar_mutex_libre()
+{
+	for (int i = 0; i != num_bloques_mutex * NUM_MUT; ++i)
+	{
+		if (obtener_mutex(i)->estado == MUTEX_ESTADO_LIBRE)
+			return i; // El mutex esta libre y devuelve su posicion en la tabla de mutex
+	}
+
+	// No hay mutex libre: se amplia la tabla con un nuevo bloque
+	int mutex_id = num_bloques_mutex * NUM_MUT;
+	if (ampliar_tabla_mutex() < 0)
+	{
+		return -1; // No hay mutex libre
+	}
+	return mutex_id;
+}
+
+static BCP *buscar_procesos_con_mutex(mutex *mut)
+{
+	BCP *p_proc = cola_bloqueados_mutex_lock.primero;
+	while (p_proc != NULL)
+	{
+		DEPURAR("\t\tID del proceso bloqueado por lock: %d\n", p_proc->id);
+		if (p_proc->mutex_esperado == mut)
+		{
+			DEPURAR("\t\tEl proceso ID %d fue bloqueado por el mutex %s poseido por %d\n",
+				   p_proc->id, mut->nombre, mut->id_proc_bloq);
+			return p_proc;
+		}
+		p_proc = p_proc->siguiente;
+	}
+	return NULL;
+}
+
+static int usado_por_otro_hilo(mutex *mut)
+{
+	BCP *lider = p_proc_actual->lider;
+	for (int i = 0; i != MAX_PROC; ++i)
+	{
+		BCP *p_proc = &(tabla_procs[i]);
+		if (p_proc == p_proc_actual || p_proc->lider != lider ||
+			p_proc->estado == NO_USADA || p_proc->estado == ZOMBI)
+		{
+			continue;
+		}
+		if ((mut->estado == MUTEX_ESTADO_BLOQUEADO && mut->id_proc_bloq == p_proc->id) ||
+			p_proc->mutex_esperado == mut)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int adquirir_mutex(unsigned int descriptor, int ciclos_plazo)
+{
+	// Como en sis_leer_caracter, la comprobacion del mutex y el bloqueo se hacen en NIVEL_3: un
+	// unlock desde una expulsion entre ambos no encontraria al proceso en la cola
+	int nivel = fijar_nivel_int(NIVEL_3);
+	int res = adquirir_mutex_sin_int(descriptor, ciclos_plazo);
+	fijar_nivel_int(nivel);
+	return res;
+}
+
+static int adquirir_mutex_sin_int(unsigned int descriptor, int ciclos_plazo)
+{
+	mutex *mutex_lock = obtener_descriptor(p_proc_actual, descriptor);
+
+	if (mutex_lock == NULL)
+	{
+		DEPURAR("\tError en lock: el mutex del proceso %d con descriptor %u no existe\n", p_proc_actual->id, descriptor);
+		return -1;
+	}
+
+	// Con politica competitiva el proceso se puede despertar y volver a bloquear varias veces:
+	// el plazo se cuenta desde la primera espera
+	int tick_limite = ticks_sistema + ciclos_plazo;
+
+	// Si se esta realizando sobre un mutex ya bloqueado
+	while (mutex_lock->estado == MUTEX_ESTADO_BLOQUEADO && mutex_lock->id_proc_bloq != p_proc_actual->id)
+	{
+		DEPURAR("\tEl proceso %d está intentando hacer lock sobre el mutex %s, ya poseido por otro proceso\n", p_proc_actual->id, mutex_lock->nombre);
+
+		if (ciclos_plazo == 0)
+		{
+			DEPURAR("\tEl mutex %s está ocupado y el proceso %d no puede esperar más\n", mutex_lock->nombre, p_proc_actual->id);
+			p_proc_actual->inicio_espera_mutex = 0;
+			return -3;
+		}
+
+		mutex_lock->num_procesos_bloqueados++;
+		DEPURAR("\tNumero de procesos bloqueados por el mutex %s: %d\n", mutex_lock->nombre, mutex_lock->num_procesos_bloqueados);
+		if (mutex_lock->num_procesos_bloqueados > mutex_lock->perfil.max_bloqueados)
+		{
+			mutex_lock->perfil.max_bloqueados = mutex_lock->num_procesos_bloqueados;
+		}
+
+		// Con politica competitiva se puede volver a bloquear: la espera cuenta desde la primera vez
+		if (p_proc_actual->inicio_espera_mutex == 0)
+		{
+			p_proc_actual->inicio_espera_mutex = leer_ciclos();
+		}
+		p_proc_actual->mutex_esperado = mutex_lock;
+		bloquear(&cola_bloqueados_mutex_lock, ciclos_plazo);
+
+		if (p_proc_actual->plazo_vencido)
+		{
+			DEPURAR("\tHa vencido el plazo del proceso %d esperando por el mutex %s\n", p_proc_actual->id, mutex_lock->nombre);
+			return -3;
+		}
+
+		// Con politica FIFO el unlock ya ha cedido el mutex a este proceso. Con politica
+		// competitiva solo se le ha despertado y debe volver a intentarlo con el plazo restante
+		if (mutex_lock->id_proc_bloq == p_proc_actual->id)
+		{
+			return 0;
+		}
+		if (obtener_descriptor(p_proc_actual, descriptor) != mutex_lock)
+		{
+			DEPURAR("\tError en lock: otro hilo ha cerrado el descriptor %u mientras se esperaba\n", descriptor);
+			p_proc_actual->inicio_espera_mutex = 0;
+			return -1;
+		}
+		if (ciclos_plazo > 0)
+		{
+			ciclos_plazo = (tick_limite > ticks_sistema) ? tick_limite - ticks_sistema : 0;
+		}
+	}
+
+	// Se procede segun el tipo de mutex
+	switch (mutex_lock->tipo)
+	{
+	case MUTEX_TIPO_RECURSIVO:
+		mutex_lock->num_locks++;
+		DEPURAR("\tNumero de locks realizados sobre el mutex %s: %d\n", mutex_lock->nombre, mutex_lock->num_locks);
+		break;
+	case MUTEX_TIPO_NO_RECURSIVO:
+		if (mutex_lock->estado == MUTEX_ESTADO_BLOQUEADO)
+		{
+			DEPURAR("\tError: El mutex no recursivo %s ya habia sido bloqueado\n", mutex_lock->nombre);
+			return -2;
+		}
+		break;
+	default:
+		DEPURAR("\tError con el mutex %s: el valor de TIPO es extraño (%d)\n", mutex_lock->nombre, mutex_lock->tipo);
+		break;
+	}
+
+	if (mutex_lock->estado != MUTEX_ESTADO_BLOQUEADO)
+	{
+		anotar_adquisicion(mutex_lock, p_proc_actual); // Un lock recursivo del propietario no es una nueva adquisicion
+	}
+	mutex_lock->estado = MUTEX_ESTADO_BLOQUEADO;
+	mutex_lock->id_proc_bloq = p_proc_actual->id;
+	DEPURAR("\tSe ha realizado lock sobre el mutex %s\n", mutex_lock->nombre);
+	return 0;
+}
+
+static void unlock(int descriptor, mutex *mutex_unlock)
+{
+	BCP *proceso_desbloquear = buscar_procesos_con_mutex(mutex_unlock);
+
+	// Desbloquear el proceso si se ha encontrado
+	if (proceso_desbloquear != NULL)
+	{
+		DEPURAR("\tEl proceso %d va a obtener el mutex %s\n", proceso_desbloquear->id, mutex_unlock->nombre);
+		// La cesion se completa sin interrupciones: si se expulsara al proceso actual antes de
+		// cambiar el propietario, el despertado veria el mutex ocupado y se volveria a bloquear
+		int nivel = fijar_nivel_int(NIVEL_3);
+
+		proceso_desbloquear->estado = LISTO;
+		proceso_desbloquear->mutex_esperado = NULL;
+		quitar_plazo(proceso_desbloquear);
+		proceso_desbloquear->cola_espera = NULL;
+		eliminar_elem(&cola_bloqueados_mutex_lock, proceso_desbloquear);
+		insertar_listo(proceso_desbloquear, CAUSA_MUTEX);
+
+		int antiguo_id = mutex_unlock->id_proc_bloq;
+
+		anotar_liberacion(mutex_unlock);
+		mutex_unlock->num_procesos_bloqueados--;
+		if (mutex_unlock->politica == MUTEX_POLITICA_COMPETITIVA)
+		{
+			// El mutex queda libre: el proceso despertado competira por el cuando se ejecute
+			mutex_unlock->id_proc_bloq = -1;
+			mutex_unlock->estado = MUTEX_ESTADO_CREADO;
+			mutex_unlock->num_locks = 0;
+			DEPURAR("\tEl mutex %s que pertenecia al proceso %d queda libre. Se ha despertado al proceso %d\n",
+				   mutex_unlock->nombre, antiguo_id, proceso_desbloquear->id);
+		}
+		else
+		{
+			mutex_unlock->id_proc_bloq = proceso_desbloquear->id;
+			mutex_unlock->num_locks = (mutex_unlock->tipo == MUTEX_TIPO_RECURSIVO) ? 1 : 0;
+			anotar_adquisicion(mutex_unlock, proceso_desbloquear);
+			DEPURAR("\tEl mutex %s que pertenecia al proceso %d ahora pertenece a %d, el cual ha sido desbloqueado\n",
+				   mutex_unlock->nombre, antiguo_id, proceso_desbloquear->id);
+		}
+		fijar_nivel_int(nivel);
+	}
+	else
+	{
+		DEPURAR("\tEl mutex %s no tiene bloqueado otros procesos\n", mutex_unlock->nombre);
+		anotar_liberacion(mutex_unlock);
+		mutex_unlock->id_proc_bloq = -1;
+		mutex_unlock->estado = MUTEX_ESTADO_CREADO;
+	}
+}
+
+static unsigned long long leer_ciclos()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int bajo, alto;
+	__asm__ __volatile__("rdtsc" : "=a"(bajo), "=d"(alto));
+	return ((unsigned long long)alto << 32) | bajo;
+#else
+	struct timespec ahora;
+	clock_gettime(CLOCK_MONOTONIC, &ahora);
+	return (unsigned long long)ahora.tv_sec * 1000000000ULL + ahora.tv_nsec;
+#endif
+}
+
+// Indice de la cubeta log2 de un tiempo: la posicion de su bit mas alto
+static int cubeta_histograma(unsigned long long ciclos)
+{
+	int cubeta = 0;
+	while (ciclos > 1 && cubeta != NUM_CUBETAS_HISTOGRAMA - 1)
+	{
+		ciclos >>= 1;
+		cubeta++;
+	}
+	return cubeta;
+}
+
+static void anotar_adquisicion(mutex *mut, BCP *proceso)
+{
+	unsigned long long ahora = leer_ciclos();
+
+	mut->perfil.adquisiciones++;
+	mut->inicio_retencion = ahora;
+
+	if (proceso->inicio_espera_mutex != 0)
+	{
+		unsigned long long espera = ahora - proceso->inicio_espera_mutex;
+		mut->perfil.adquisiciones_disputadas++;
+		mut->perfil.espera_total += espera;
+		if (espera > mut->perfil.espera_max)
+		{
+			mut->perfil.espera_max = espera;
+		}
+		mut->perfil.histograma_espera[cubeta_histograma(espera)]++;
+		proceso->inicio_espera_mutex = 0;
+	}
+}
+
+static void anotar_liberacion(mutex *mut)
+{
+	unsigned long long retencion = leer_ciclos() - mut->inicio_retencion;
+
+	mut->perfil.liberaciones++;
+	mut->perfil.retencion_total += retencion;
+	if (retencion > mut->perfil.retencion_max)
+	{
+		mut->perfil.retencion_max = retencion;
+	}
+	mut->perfil.histograma_retencion[cubeta_histograma(retencion)]++;
+}
+
+static void volcar_perfil_mutex()
+{
+	printk("[PERFIL_MUTEX]\n");
+	for (int i = 0; i != num_bloques_mutex * NUM_MUT; ++i)
+	{
+		perfil_mutex *perfil = &(obtener_mutex(i)->perfil);
+		if (perfil->adquisiciones == 0)
+		{
+			continue;
+		}
+
+		printk("\tMutex %d (%s): %d adquisiciones, %d disputadas, maximo %d bloqueados\n", i, perfil->nombre,
+			   perfil->adquisiciones, perfil->adquisiciones_disputadas, perfil->max_bloqueados);
+		if (perfil->adquisiciones_disputadas > 0)
+		{
+			printk("\t\tEspera media %llu ciclos, maxima %llu\n",
+				   perfil->espera_total / perfil->adquisiciones_disputadas, perfil->espera_max);
+		}
+		if (perfil->liberaciones > 0)
+		{
+			printk("\t\tRetencion media %llu ciclos, maxima %llu\n",
+				   perfil->retencion_total / perfil->liberaciones, perfil->retencion_max);
+		}
+		for (int c = 0; c != NUM_CUBETAS_HISTOGRAMA; ++c)
+		{
+			if (perfil->histograma_espera[c] != 0 || perfil->histograma_retencion[c] != 0)
+			{
+				printk("\t\t[2^%d, 2^%d) ciclos: %d esperas, %d retenciones\n", c, c + 1,
+					   perfil->histograma_espera[c], perfil->histograma_retencion[c]);
+			}
+		}
+	}
+}
+
+static void sumar_llamada(perfil_llamada *perfil, unsigned long long ciclos)
+{
+	if (perfil->llamadas == 0 || ciclos < perfil->ciclos_min)
+	{
+		perfil->ciclos_min = ciclos;
+	}
+	if (ciclos > perfil->ciclos_max)
+	{
+		perfil->ciclos_max = ciclos;
+	}
+	perfil->llamadas++;
+	perfil->ciclos_total += ciclos;
+	perfil->histograma[cubeta_histograma(ciclos)]++;
+}
+
+static void anotar_llamada(int servicio, unsigned long long ciclos)
+{
+	sumar_llamada(&(perfil_llamadas[servicio]), ciclos);
+	sumar_llamada(&(p_proc_actual->perfil_llamadas[servicio]), ciclos);
+}
+
+static void volcar_perfil_llamadas()
+{
+	printk("[PERFIL_LLAMADAS]\n");
+	for (int servicio = 0; servicio != NSERVICIOS; ++servicio)
+	{
+		perfil_llamada *perfil = &(perfil_llamadas[servicio]);
+		if (perfil->llamadas == 0)
+		{
+			continue;
+		}
+
+		printk("\tServicio %d: %d llamadas, %llu ciclos en total, media %llu, minimo %llu, maximo %llu\n", servicio,
+			   perfil->llamadas, perfil->ciclos_total, perfil->ciclos_total / perfil->llamadas, perfil->ciclos_min, perfil->ciclos_max);
+		for (int c = 0; c != NUM_CUBETAS_HISTOGRAMA; ++c)
+		{
+			if (perfil->histograma[c] != 0)
+			{
+				printk("\t\t[2^%d, 2^%d) ciclos: %d llamadas\n", c, c + 1, perfil->histograma[c]);
+			}
+		}
+	}
+}
+
+static void marcar_listo(BCP *proc, int causa)
+{
+	proc->instante_listo = leer_ciclos();
+	proc->causa_listo = causa;
+}
+
+static void anotar_despacho(BCP *proc)
+{
+	// El proceso en ejecucion tambien pasa por el planificador: solo cuenta si estaba esperando
+	if (proc->instante_listo == 0)
+	{
+		return;
+	}
+
+	unsigned long long latencia = leer_ciclos() - proc->instante_listo;
+	int causa = proc->causa_listo;
+	latencias.despachos[causa]++;
+	latencias.latencia_total[causa] += latencia;
+	if (latencia > latencias.latencia_max[causa])
+	{
+		latencias.latencia_max[causa] = latencia;
+	}
+	latencias.histograma[causa][cubeta_histograma(latencia)]++;
+	proc->instante_listo = 0;
+}
+
+static void anotar_longitud_listos()
+{
+	int longitud = 0;
+	for (BCP *p_proc = cola_listos.primero; p_proc != NULL; p_proc = p_proc->siguiente)
+	{
+		longitud++;
+	}
+	// El proceso en ejecucion esta en cabeza de la cola de listos pero no espera
+	if (p_proc_actual != NULL && p_proc_actual->estado == LISTO)
+	{
+		longitud--;
+	}
+
+	latencias.historial_listos[ticks_sistema % TAM_HISTORIAL_LISTOS] = longitud;
+	latencias.ticks_con_longitud[longitud]++;
+	latencias.ticks++;
+}
+
+static void iniciar_muestreo()
+{
+	// El HAL no guarda el contexto del proceso al interrumpirlo: el contador de programa
+	// solo esta en el marco de la senal. Se intercala capturar_pc delante de su manejador
+	struct sigaction captura;
+	sigaction(SIGALRM, NULL, &manejador_reloj_hal);
+	captura = manejador_reloj_hal;
+	captura.sa_sigaction = capturar_pc;
+	captura.sa_flags |= SA_SIGINFO;
+	sigaction(SIGALRM, &captura, NULL);
+}
+
+static void capturar_pc(int senal, siginfo_t *info, void *contexto)
+{
+#if defined(__x86_64__)
+	pc_interrumpido = (void *)((ucontext_t *)contexto)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+	pc_interrumpido = (void *)((ucontext_t *)contexto)->uc_mcontext.gregs[REG_EIP];
+#endif
+	if (manejador_reloj_hal.sa_flags & SA_SIGINFO)
+	{
+		manejador_reloj_hal.sa_sigaction(senal, info, contexto);
+	}
+	else
+	{
+		manejador_reloj_hal.sa_handler(senal);
+	}
+}
+
+static void tomar_muestra()
+{
+	if (periodo_muestreo == 0 || ticks_sistema % periodo_muestreo != 0 || pc_interrumpido == NULL)
+	{
+		return;
+	}
+	// Mientras el procesador esta ocioso p_proc_actual no esta en ejecucion
+	if (p_proc_actual == NULL || p_proc_actual->estado != LISTO)
+	{
+		return;
+	}
+
+	if (p_proc_actual->num_muestras == NUM_MUESTRAS)
+	{
+		p_proc_actual->muestras_perdidas++;
+		return;
+	}
+	p_proc_actual->muestras[p_proc_actual->num_muestras++] = pc_interrumpido;
+}
+
+static void calibrar_reloj()
+{
+	ciclos_arranque = leer_ciclos();
+
+	// Se cuentan los ciclos entre dos cambios del reloj CMOS para no depender de la fase inicial
+	unsigned long long ms = leer_reloj_CMOS();
+	while (leer_reloj_CMOS() == ms)
+		;
+	unsigned long long ms_inicio = leer_reloj_CMOS();
+	unsigned long long ciclos_inicio = leer_ciclos();
+	while (leer_reloj_CMOS() - ms_inicio < MS_CALIBRACION)
+		;
+	ciclos_por_ms = (leer_ciclos() - ciclos_inicio) / MS_CALIBRACION;
+}
+
+static unsigned long long ns_desde_arranque()
+{
+	unsigned long long ciclos = leer_ciclos() - ciclos_arranque;
+
+	// Se divide por partes para que ciclos * 1000000 no desborde
+	return (ciclos / ciclos_por_ms) * 1000000ULL + (ciclos % ciclos_por_ms) * 1000000ULL / ciclos_por_ms;
+}
+
+static void iniciar_pagina_tiempo()
+{
+	// Dos proyecciones del mismo fichero anonimo: los procesos no pueden escribir en la suya
+	int fd = memfd_create("minikernel_tiempo", 0);
+	if (fd >= 0 && ftruncate(fd, TAM_PAGINA) == 0)
+	{
+		void *escritura = mmap(NULL, TAM_PAGINA, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		void *lectura = mmap(NULL, TAM_PAGINA, PROT_READ, MAP_SHARED, fd, 0);
+		if (escritura != MAP_FAILED && lectura != MAP_FAILED)
+		{
+			tiempo_compartido = (pagina_tiempo *)escritura;
+			tiempo_compartido_usuario = (const pagina_tiempo *)lectura;
+		}
+	}
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+	if (tiempo_compartido == &pagina_tiempo_estatica)
+	{
+		DEPURAR("\tNo se ha podido crear la pagina de tiempo de solo lectura\n");
+	}
+
+	tiempo_compartido->ticks = ticks_sistema;
+	tiempo_compartido->ciclos_arranque = ciclos_arranque;
+	tiempo_compartido->ciclos_por_ms = ciclos_por_ms;
+}
+
+static void iniciar_traza()
+{
+	char *mascara = getenv("MINIKERNEL_TRAZA");
+	if (mascara != NULL)
+	{
+		mascara_traza = (int)strtol(mascara, NULL, 0) & TRAZA_TODAS;
+	}
+}
+
+static void iniciar_eventos_externos()
+{
+	char *grabar = getenv("MINIKERNEL_GRABAR");
+	char *reproducir = getenv("MINIKERNEL_REPRODUCIR");
+
+	if (reproducir != NULL)
+	{
+		FILE *f = fopen(reproducir, "r");
+		if (f == NULL)
+		{
+			panico("No se puede abrir el fichero de MINIKERNEL_REPRODUCIR");
+		}
+
+		// Formato de grabar_evento: "R posicion" o "T posicion caracter"
+		int capacidad = 1024;
+		eventos_externos = malloc(capacidad * sizeof(evento_externo));
+		char tipo;
+		unsigned int posicion;
+		while (eventos_externos != NULL && fscanf(f, " %c %u", &tipo, &posicion) == 2)
+		{
+			if (num_eventos_externos == capacidad)
+			{
+				capacidad *= 2;
+				eventos_externos = realloc(eventos_externos, capacidad * sizeof(evento_externo));
+				if (eventos_externos == NULL)
+				{
+					break;
+				}
+			}
+			evento_externo *ev = &(eventos_externos[num_eventos_externos++]);
+			ev->posicion = posicion;
+			ev->tipo = (tipo == 'T') ? EXTERNO_TERMINAL : EXTERNO_RELOJ;
+			ev->dato = 0;
+			if (ev->tipo == EXTERNO_TERMINAL && fscanf(f, "%d", &(ev->dato)) != 1)
+			{
+				panico("Evento de terminal sin caracter en MINIKERNEL_REPRODUCIR");
+			}
+		}
+		fclose(f);
+		if (eventos_externos == NULL)
+		{
+			panico("No hay memoria para los eventos de MINIKERNEL_REPRODUCIR");
+		}
+		modo_eventos = EVENTOS_REPRODUCIR;
+	}
+	else if (grabar != NULL)
+	{
+		fichero_eventos = fopen(grabar, "w");
+		if (fichero_eventos == NULL)
+		{
+			panico("No se puede crear el fichero de MINIKERNEL_GRABAR");
+		}
+		modo_eventos = EVENTOS_GRABAR;
+	}
+}
+
+static void grabar_evento(int tipo, int dato)
+{
+	if (tipo == EXTERNO_TERMINAL)
+	{
+		fprintf(fichero_eventos, "T %u %d\n", llamadas_realizadas, dato);
+	}
+	else
+	{
+		fprintf(fichero_eventos, "R %u\n", llamadas_realizadas);
+	}
+}
+
+static void reproducir_eventos(int reloj_real)
+{
+	while (siguiente_evento_externo != num_eventos_externos)
+	{
+		evento_externo *ev = &(eventos_externos[siguiente_evento_externo]);
+		if (ev->posicion > llamadas_realizadas)
+		{
+			return; // Los procesos aun no han llegado: el tick real se pierde
+		}
+		siguiente_evento_externo++;
+
+		if (ev->tipo == EXTERNO_TERMINAL)
+		{
+			recibir_caracter((char)ev->dato);
+			continue;
+		}
+		tratar_tick();
+		if (reloj_real)
+		{
+			return; // Cada interrupcion real reproduce un tick como mucho
+		}
+	}
+}
+
+static void terminar_eventos_externos()
+{
+	if (modo_eventos == EVENTOS_GRABAR)
+	{
+		printk("[EVENTOS_EXTERNOS] Grabacion terminada tras %u llamadas al sistema\n", llamadas_realizadas);
+		fclose(fichero_eventos);
+		fichero_eventos = NULL;
+		modo_eventos = EVENTOS_NORMAL;
+	}
+	else if (modo_eventos == EVENTOS_REPRODUCIR)
+	{
+		printk("[EVENTOS_EXTERNOS] Reproducidos %d de %d eventos en %u llamadas al sistema\n",
+			   siguiente_evento_externo, num_eventos_externos, llamadas_realizadas);
+	}
+}
+
+static void trazar(int tipo, int dato1, int dato2)
+{
+	// El incremento atomico reserva la entrada aunque una interrupcion anote otro evento a la vez
+	unsigned int indice = __sync_fetch_and_add(&traza_siguiente, 1) % TAM_TRAZA;
+	evento_traza *evento = &(traza[indice]);
+
+	evento->ciclos = leer_ciclos();
+	evento->tipo = tipo;
+	evento->proceso = (p_proc_actual != NULL) ? p_proc_actual->id : -1;
+	evento->dato1 = dato1;
+	evento->dato2 = dato2;
+}
+
+static void cerrar(int descriptor, mutex *mutex_cerrar)
+{
+	fijar_descriptor(p_proc_actual, descriptor, NULL);
+
+	// Si el proceso poseia el mutex se libera, otorgandolo a otro proceso bloqueado si lo hubiera
+	if (mutex_cerrar->id_proc_bloq == p_proc_actual->id)
+	{
+		DEPURAR("\tNumero de procesos bloqueados por el mutex %s: %d\n", mutex_cerrar->nombre, mutex_cerrar->num_procesos_bloqueados);
+		mutex_cerrar->num_locks = 0;
+		unlock(descriptor, mutex_cerrar);
+	}
+
+	mutex_cerrar->num_aperturas--;
+	DEPURAR("\tEl mutex %s sigue abierto por %d descriptores\n", mutex_cerrar->nombre, mutex_cerrar->num_aperturas);
+	if (mutex_cerrar->num_aperturas > 0)
+	{
+		return;
+	}
+
+	// Nadie mas lo tiene abierto: eliminar el mutex y liberar un proceso bloqueado esperando por un mutex
+	mutex_cerrar->nombre[0] = '\0';
+	mutex_cerrar->estado = MUTEX_ESTADO_LIBRE;
+	mutex_cerrar->tipo = -1;
+	mutex_cerrar->num_locks = 0;
+	mutex_cerrar->num_procesos_bloqueados = 0;
+	mutex_cerrar->id_proc_bloq = -1;
+	mutex_cerrar->num_aperturas = 0;
+
+	despertar_creador_mutex();
+}
+
+static void despertar_creador_mutex()
+{
+	DEPURAR("\tSe va a buscar un proceso bloqueado por SIS_CREAR_MUTEX\n");
+	BCP *p_proc = despertar_primero(&cola_bloqueados_mutex_libre);
+	if (p_proc != NULL)
+	{
+		DEPURAR("\tSe ha desbloqueado el proceso %d bloqueado por SIS_CREAR_MUTEX\n", p_proc->id);
+	}
+	else
+	{
+		DEPURAR("\tNo se ha encontrado ninguno\n");
+	}
+}
+
+static BCP *despertar_primero(lista_BCPs *lista)
+{
+	BCP *p_proc = lista->primero;
+	if (p_proc != NULL)
+	{
+		int nivel = fijar_nivel_int(NIVEL_3);
+
+		p_proc->estado = LISTO;
+		quitar_plazo(p_proc);
+		p_proc->cola_espera = NULL;
+		eliminar_elem(lista, p_proc);
+		if (lista == &cola_bloqueados_terminal)
+		{
+			insertar_listo(p_proc, CAUSA_TERMINAL);
+		}
+		else
+		{
+			insertar_listo(p_proc, (lista == &cola_bloqueados_mutex_libre) ? CAUSA_MUTEX : CAUSA_OTRA);
+		}
+
+		fijar_nivel_int(nivel);
+	}
+	return p_proc;
+}
+
+// Colas de mensajes
+int sis_reservar_buffer()
+{
+	DEPURAR("[SIS_RESERVAR_BUFFER()]\n");
+
+	int tam = (int)leer_registro(1);
+	void **dir = (void **)leer_registro(2);
+
+	DEPURAR("\tArg1 (Tam): %d\n", tam);
+
+	if (tam <= 0)
+	{
+		DEPURAR("\tError reservando el buffer: tamaño no valido\n");
+		return -1;
+	}
+
+	buffer_mensaje *buffer = malloc(sizeof(buffer_mensaje) + tam);
+	if (buffer == NULL)
+	{
+		DEPURAR("\tError reservando el buffer: no hay memoria\n");
 		return -2;
 	}
 
-	int descriptor = buscar_descriptor_libre();
-	if (descriptor < 0)
+	buffer->marca = BUFFER_MARCA;
+	buffer->propietario = p_proc_actual->lider->id;
+	buffer->tam = tam;
+	buffer->anterior = NULL;
+	buffer->siguiente = buffers_reservados;
+	if (buffers_reservados != NULL)
 	{
-		printk("\tError creando el mutex: no hay descriptores disponibles\n");
-		return -3;
+		buffers_reservados->anterior = buffer;
 	}
+	buffers_reservados = buffer;
 
-	int mutex_id = buscar_mutex_libre();
-	if (mutex_id < 0)
+	*dir = buffer + 1; // Los datos siguen a la cabecera
+	return 0;
+}
+
+int sis_liberar_buffer()
+{
+	DEPURAR("[SIS_LIBERAR_BUFFER()]\n");
+
+	buffer_mensaje *buffer = obtener_buffer((void *)leer_registro(1));
+	if (buffer == NULL)
+	{
+		DEPURAR("\tError liberando el buffer: no pertenece al proceso %d\n", p_proc_actual->id);
+		return -1;
+	}
+
+	if (buffer->anterior != NULL)
+	{
+		buffer->anterior->siguiente = buffer->siguiente;
+	}
+	else
 	{
-		printk("\tNo hay mutex disponibles en el sistema. Se va a bloquear el sistema hasta que se libere alguno\n");
-		BCP *proceso_a_bloquear = p_proc_actual;
+		buffers_reservados = buffer->siguiente;
+	}
+	if (buffer->siguiente != NULL)
+	{
+		buffer->siguiente->anterior = buffer->anterior;
+	}
 
-		proceso_a_bloquear->estado = BLOQUEADO;
+	buffer->marca = 0;
+	free(buffer);
+	return 0;
+}
 
-		int nivel = fijar_nivel_int(NIVEL_3);
+int sis_crear_cola()
+{
+	DEPURAR("[SIS_CREAR_COLA()]\n");
 
-		eliminar_elem(&cola_listos, proceso_a_bloquear);
-		insertar_ultimo(&cola_bloqueados_mutex_libre, proceso_a_bloquear);
+	char *nombre_cola = (char *)leer_registro(1);
+	int capacidad = (int)leer_registro(2);
 
-		p_proc_actual = planificador();
+	DEPURAR("\tArg1 (Nombre): %s, Arg2 (Capacidad): %d\n", nombre_cola, capacidad);
 
-		fijar_nivel_int(nivel);
-		cambio_contexto(&(proceso_a_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
+	if (strlen(nombre_cola) + 1 > MAX_NOM_COLA)
+	{
+		DEPURAR("\tError creando la cola: el nombre es demasiado largo\n");
+		return -1;
 	}
-	else
+
+	int id_cola = buscar_nombre_cola(nombre_cola);
+	if (id_cola >= 0)
 	{
-		mutex *nuevo_mutex = &(tabla_mutex[mutex_id]);
+		DEPURAR("\tLa cola %s ya existe con id %d\n", nombre_cola, id_cola);
+		return id_cola;
+	}
 
-		strcpy(nuevo_mutex->nombre, nombre_mutex);
-		nuevo_mutex->estado = MUTEX_ESTADO_CREADO;
-		nuevo_mutex->tipo = tipo_mutex;
-		nuevo_mutex->num_locks = 0;
-		nuevo_mutex->num_procesos_bloqueados = 0;
-		nuevo_mutex->id_proc_bloq = -1;
+	if (capacidad <= 0 || capacidad > MAX_MENSAJES_COLA)
+	{
+		DEPURAR("\tError creando la cola: la capacidad debe estar entre 1 y %d\n", MAX_MENSAJES_COLA);
+		return -2;
+	}
 
-		p_proc_actual->descriptores_mutex[descriptor] = nuevo_mutex;
+	for (id_cola = 0; id_cola != NUM_COLAS; ++id_cola)
+	{
+		cola_mensajes *cola = &(tabla_colas[id_cola]);
+		if (!cola->usada)
+		{
+			strcpy(cola->nombre, nombre_cola);
+			cola->usada = 1;
+			cola->capacidad = capacidad;
+			cola->primero = 0;
+			cola->num_mensajes = 0;
+			DEPURAR("\tSe ha creado la cola %s con id %d\n", nombre_cola, id_cola);
+			return id_cola;
+		}
 	}
 
-	printk("\tSe ha creado el mutex %s con el descriptor %d\n", nombre_mutex, descriptor);
-	return descriptor;
+	DEPURAR("\tError creando la cola: no hay colas disponibles en el sistema\n");
+	return -3;
 }
 
-int sis_abrir_mutex()
+int sis_enviar()
 {
-	printk("[SIS_ABRIR_MUTEX()]\n");
+	DEPURAR("[SIS_ENVIAR()]\n");
 
-	char *nombre_mutex = (char *)leer_registro(1);
-	printk("\tArg1 (Nombre): %s\n", nombre_mutex);
+	unsigned int id_cola = (unsigned int)leer_registro(1);
+	void *dir = (void *)leer_registro(2);
+	int tam = (int)leer_registro(3);
+	int bloqueante = (int)leer_registro(4);
 
-	int mutex_id = buscar_nombre_mutex(nombre_mutex);
-	if (mutex_id < 0)
+	DEPURAR("\tArg1 (Cola): %u, Arg3 (Tam): %d, Arg4 (Bloqueante): %d\n", id_cola, tam, bloqueante);
+
+	cola_mensajes *cola = obtener_cola(id_cola);
+	if (cola == NULL)
 	{
-		printk("\tError abriendo el mutex: no existe ningún mutex llamado %s\n", nombre_mutex);
+		DEPURAR("\tError enviando: no existe la cola %u\n", id_cola);
 		return -1;
 	}
 
-	int descriptor = buscar_descriptor_libre();
-	if (descriptor < 0)
+	buffer_mensaje *buffer = obtener_buffer(dir);
+	if (buffer == NULL || tam < 0 || tam > buffer->tam)
 	{
-		printk("\tError abriendo el mutex: se ha alcanzado el límite de mutex por proceso\n", nombre_mutex, descriptor);
+		DEPURAR("\tError enviando: el buffer no pertenece al proceso %d o el tamaño no es valido\n", p_proc_actual->id);
 		return -2;
 	}
 
-	printk("\tSe ha abierto el mutex %s. Descriptor: %d\n", nombre_mutex, descriptor);
-	p_proc_actual->descriptores_mutex[descriptor] = &(tabla_mutex[mutex_id]);
-	return descriptor;
+	while (cola->num_mensajes == cola->capacidad)
+	{
+		if (!bloqueante)
+		{
+			DEPURAR("\tLa cola %s esta llena\n", cola->nombre);
+			return -3;
+		}
+		DEPURAR("\tLa cola %s esta llena. Se bloquea el proceso %d\n", cola->nombre, p_proc_actual->id);
+		bloquear(&(cola->emisores_bloqueados), -1);
+
+		// Mientras esperaba, otro hilo del proceso ha podido liberar o enviar el buffer
+		if (obtener_buffer(dir) != buffer)
+		{
+			DEPURAR("\tError enviando: el buffer ya no pertenece al proceso %d\n", p_proc_actual->id);
+			despertar_primero(&(cola->emisores_bloqueados)); // El hueco queda para otro emisor
+			return -2;
+		}
+	}
+
+	// El buffer pasa a la cola sin copiar su contenido
+	mensaje *msj = &(cola->mensajes[(cola->primero + cola->num_mensajes) % MAX_MENSAJES_COLA]);
+	msj->buffer = dir;
+	msj->tam = tam;
+	cola->num_mensajes++;
+	buffer->propietario = -1;
+
+	despertar_primero(&(cola->receptores_bloqueados));
+	return 0;
 }
 
-int sis_lock_mutex()
+int sis_recibir()
 {
-	printk("[SIS_LOCK_MUTEX()]\n");
+	DEPURAR("[SIS_RECIBIR()]\n");
 
-	unsigned int descriptor = (unsigned int)leer_registro(1);
-
-	printk("\tArg1 (Descriptor): %u\n", descriptor);
+	unsigned int id_cola = (unsigned int)leer_registro(1);
+	void **dir = (void **)leer_registro(2);
+	int bloqueante = (int)leer_registro(3);
 
-	mutex *mutex_lock = p_proc_actual->descriptores_mutex[descriptor];
+	DEPURAR("\tArg1 (Cola): %u, Arg3 (Bloqueante): %d\n", id_cola, bloqueante);
 
-	if (mutex_lock == NULL)
+	cola_mensajes *cola = obtener_cola(id_cola);
+	if (cola == NULL)
 	{
-		printk("\tError en lock: el mutex del proceso %d con descriptor %u no existe\n", p_proc_actual->id, descriptor);
+		DEPURAR("\tError recibiendo: no existe la cola %u\n", id_cola);
 		return -1;
 	}
 
-	// Si se esta realizando sobre un mutex ya bloqueado
-	if (mutex_lock->estado == MUTEX_ESTADO_BLOQUEADO && mutex_lock->id_proc_bloq != p_proc_actual->id)
+	while (cola->num_mensajes == 0)
 	{
-		printk("\tEl proceso %d está intentando hacer lock sobre el mutex %s, ya poseido por otro proceso\n", p_proc_actual->id, mutex_lock->nombre);
+		if (!bloqueante)
+		{
+			DEPURAR("\tLa cola %s esta vacia\n", cola->nombre);
+			return -3;
+		}
+		DEPURAR("\tLa cola %s esta vacia. Se bloquea el proceso %d\n", cola->nombre, p_proc_actual->id);
+		bloquear(&(cola->receptores_bloqueados), -1);
+	}
 
-		mutex_lock->num_procesos_bloqueados++;
-		printk("\tNumero de procesos bloqueados por el mutex %s: %d\n", mutex_lock->nombre, mutex_lock->num_procesos_bloqueados);
+	// El proceso pasa a ser el propietario del buffer del mensaje
+	mensaje *msj = &(cola->mensajes[cola->primero]);
+	((buffer_mensaje *)msj->buffer - 1)->propietario = p_proc_actual->lider->id;
+	*dir = msj->buffer;
+	int tam = msj->tam;
+	cola->primero = (cola->primero + 1) % MAX_MENSAJES_COLA;
+	cola->num_mensajes--;
 
-		BCP *proceso_a_bloquear = p_proc_actual;
+	despertar_primero(&(cola->emisores_bloqueados));
+	return tam;
+}
 
-		proceso_a_bloquear->estado = BLOQUEADO;
+static void iniciar_tabla_colas()
+{
+	for (int i = 0; i != NUM_COLAS; ++i)
+	{
+		tabla_colas[i].usada = 0;
+		tabla_colas[i].nombre[0] = '\0';
+		tabla_colas[i].emisores_bloqueados.primero = NULL;
+		tabla_colas[i].emisores_bloqueados.ultimo = NULL;
+		tabla_colas[i].receptores_bloqueados.primero = NULL;
+		tabla_colas[i].receptores_bloqueados.ultimo = NULL;
+	}
+}
 
-		int nivel = fijar_nivel_int(NIVEL_3);
+static int buscar_nombre_cola(char *nombre_cola)
+{
+	for (int i = 0; i != NUM_COLAS; ++i)
+	{
+		if (tabla_colas[i].usada && strcmp(tabla_colas[i].nombre, nombre_cola) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
 
-		eliminar_elem(&cola_listos, proceso_a_bloquear);
-		insertar_ultimo(&cola_bloqueados_mutex_lock, proceso_a_bloquear);
+static cola_mensajes *obtener_cola(unsigned int id_cola)
+{
+	if (id_cola >= NUM_COLAS || !tabla_colas[id_cola].usada)
+	{
+		return NULL;
+	}
+	return &(tabla_colas[id_cola]);
+}
 
-		p_proc_actual = planificador();
+static buffer_mensaje *obtener_buffer(void *dir)
+{
+	if (dir == NULL)
+	{
+		return NULL;
+	}
 
-		fijar_nivel_int(nivel);
-		cambio_contexto(&(proceso_a_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
-		return 0;
+	// Solo se lee la cabecera de un buffer reservado: dir puede ser cualquier puntero
+	buffer_mensaje *buffer = buffers_reservados;
+	while (buffer != NULL && buffer + 1 != dir)
+	{
+		buffer = buffer->siguiente;
 	}
+	if (buffer == NULL || buffer->marca != BUFFER_MARCA || buffer->propietario != p_proc_actual->lider->id)
+	{
+		return NULL; // No reservado, cabecera sobrescrita por el usuario o de otro proceso
+	}
+	return buffer;
+}
 
-	// Se procede segun el tipo de mutex
-	switch (mutex_lock->tipo)
+static void liberar_buffers()
+{
+	buffer_mensaje *buffer = buffers_reservados;
+	while (buffer != NULL)
 	{
-	case MUTEX_TIPO_RECURSIVO:
-		mutex_lock->num_locks++;
-		printk("\tNumero de locks realizados sobre el mutex %s: %d\n", mutex_lock->nombre, mutex_lock->num_locks);
-		break;
-	case MUTEX_TIPO_NO_RECURSIVO:
-		if (mutex_lock->estado == MUTEX_ESTADO_BLOQUEADO)
+		buffer_mensaje *siguiente = buffer->siguiente;
+		if (buffer->propietario == p_proc_actual->lider->id)
 		{
-			printk("\tError: El mutex no recursivo %s ya habia sido bloqueado\n", mutex_lock->nombre);
-			return -2;
+			if (buffer->anterior != NULL)
+			{
+				buffer->anterior->siguiente = siguiente;
+			}
+			else
+			{
+				buffers_reservados = siguiente;
+			}
+			if (siguiente != NULL)
+			{
+				siguiente->anterior = buffer->anterior;
+			}
+			buffer->marca = 0;
+			free(buffer);
 		}
-		break;
-	default:
-		printk("\tError con el mutex %s: el valor de TIPO es extraño (%d)\n", mutex_lock->nombre, mutex_lock->tipo);
-		break;
+		buffer = siguiente;
 	}
-
-	mutex_lock->estado = MUTEX_ESTADO_BLOQUEADO;
-	mutex_lock->id_proc_bloq = p_proc_actual->id;
-	printk("\tSe ha realizado lock sobre el mutex %s\n", mutex_lock->nombre);
-	return 0;
 }
 
-int sis_unlock_mutex()
+// Memoria compartida
+int sis_crear_memoria_compartida()
 {
-	printk("[SIS_UNLOCK_MUTEX()]\n");
-
-	unsigned int descriptor = (unsigned int)leer_registro(1);
+	DEPURAR("[SIS_CREAR_MEMORIA_COMPARTIDA()]\n");
 
-	printk("\tArg1 (Descriptor): %u\n", descriptor);
+	char *nombre_segmento = (char *)leer_registro(1);
+	int tam = (int)leer_registro(2);
+	void **dir = (void **)leer_registro(3);
 
-	mutex *mutex_unlock = p_proc_actual->descriptores_mutex[descriptor];
+	DEPURAR("\tArg1 (Nombre): %s, Arg2 (Tam): %d\n", nombre_segmento, tam);
 
-	if (mutex_unlock == NULL)
+	if (strlen(nombre_segmento) + 1 > MAX_NOM_SEG)
 	{
-		printk("\tError en unlock: el mutex con descriptor %u no existe\n", descriptor);
+		DEPURAR("\tError creando el segmento: el nombre es demasiado largo\n");
 		return -1;
 	}
 
-	if (mutex_unlock->estado != MUTEX_ESTADO_BLOQUEADO)
+	if (buscar_nombre_segmento(nombre_segmento) >= 0)
 	{
-		printk("\tError en unlock: el mutex %s no está bloqueado\n", mutex_unlock->nombre);
+		DEPURAR("\tError creando el segmento: ya existe un segmento con ese nombre\n");
 		return -2;
 	}
 
-	if (mutex_unlock->id_proc_bloq != p_proc_actual->id)
+	if (tam <= 0)
 	{
-		printk("\tError en unlock: el proceso %d no puede hacer unlock sobre el mutex %s. Debe hacerlo %d\n",
-			   p_proc_actual->id, mutex_unlock->nombre, mutex_unlock->id_proc_bloq);
+		DEPURAR("\tError creando el segmento: tamaño no valido\n");
 		return -3;
 	}
 
-	switch (mutex_unlock->tipo)
+	int id_segmento;
+	for (id_segmento = 0; id_segmento != NUM_SEGMENTOS; ++id_segmento)
 	{
-	case MUTEX_TIPO_NO_RECURSIVO:
-		break;
-	case MUTEX_TIPO_RECURSIVO:
-		mutex_unlock->num_locks--;
-		printk("\tHace falta realizar unlock sobre el mutex recursivo %s %d veces mas\n", mutex_unlock->nombre, mutex_unlock->num_locks);
-		break;
-	default:
-		printk("\tError con el mutex %s: el valor de TIPO es extraño (%d)\n", mutex_unlock->nombre, mutex_unlock->tipo);
-		break;
+		if (!tabla_segmentos[id_segmento].usado)
+		{
+			break;
+		}
+	}
+	if (id_segmento == NUM_SEGMENTOS)
+	{
+		DEPURAR("\tError creando el segmento: no hay segmentos disponibles en el sistema\n");
+		return -4;
 	}
 
-	if (mutex_unlock->num_locks == 0)
+	int num_paginas = (tam + TAM_PAGINA - 1) / TAM_PAGINA;
+	int primera = reservar_paginas(num_paginas);
+	if (primera < 0)
 	{
-		unlock(descriptor, mutex_unlock);
+		DEPURAR("\tError creando el segmento: no hay %d paginas contiguas libres\n", num_paginas);
+		return -5;
+	}
+
+	segmento *seg = &(tabla_segmentos[id_segmento]);
+	strcpy(seg->nombre, nombre_segmento);
+	seg->usado = 1;
+	seg->tam = tam;
+	seg->primera_pagina = primera;
+	seg->num_paginas = num_paginas;
+	seg->referencias = 1;
+	for (int i = primera; i != primera + num_paginas; ++i)
+	{
+		paginas_compartidas[i] = id_segmento;
 	}
-	printk("\tSe ha realizado unlock sobre el mutex %s\n", mutex_unlock->nombre);
+
+	char *inicio = &(zona_compartida[primera * TAM_PAGINA]);
+	memset(inicio, 0, num_paginas * TAM_PAGINA);
+
+	p_proc_actual->lider->segmentos_abiertos[id_segmento]++;
+	*dir = inicio;
+	DEPURAR("\tSe ha creado el segmento %s con %d paginas a partir de la pagina %d\n", nombre_segmento, num_paginas, primera);
 	return 0;
 }
 
-int sis_cerrar_mutex()
+int sis_abrir_memoria_compartida()
 {
-	printk("[SIS_CERRAR_MUTEX()]\n");
+	DEPURAR("[SIS_ABRIR_MEMORIA_COMPARTIDA()]\n");
 
-	unsigned int descriptor = (unsigned int)leer_registro(1);
-
-	printk("\tArg1 (Descriptor): %u\n", descriptor);
+	char *nombre_segmento = (char *)leer_registro(1);
+	void **dir = (void **)leer_registro(2);
 
-	mutex *mutex_cerrar = p_proc_actual->descriptores_mutex[descriptor];
+	DEPURAR("\tArg1 (Nombre): %s\n", nombre_segmento);
 
-	if (mutex_cerrar == NULL)
+	int id_segmento = buscar_nombre_segmento(nombre_segmento);
+	if (id_segmento < 0)
 	{
-		printk("\tError cerrando el mutex: no existe el mutex con descriptor %u\n", descriptor);
+		DEPURAR("\tError abriendo el segmento: no existe ningun segmento llamado %s\n", nombre_segmento);
 		return -1;
 	}
 
-	cerrar(descriptor, mutex_cerrar);
-	return 0;
+	segmento *seg = &(tabla_segmentos[id_segmento]);
+	seg->referencias++;
+	p_proc_actual->lider->segmentos_abiertos[id_segmento]++;
+	*dir = &(zona_compartida[seg->primera_pagina * TAM_PAGINA]);
+	return seg->tam;
 }
 
-static void iniciar_tabla_mutex()
+int sis_cerrar_memoria_compartida()
 {
-	for (int i = 0; i != NUM_MUT; ++i)
+	DEPURAR("[SIS_CERRAR_MEMORIA_COMPARTIDA()]\n");
+
+	void *dir = (void *)leer_registro(1);
+
+	int id_segmento = buscar_segmento_dir(dir);
+	if (id_segmento < 0 || p_proc_actual->lider->segmentos_abiertos[id_segmento] == 0)
 	{
-		strcpy(tabla_mutex[i].nombre, "NO MUTEX");
-		tabla_mutex[i].mutex_id = i;
-		tabla_mutex[i].estado = MUTEX_ESTADO_LIBRE;
-		tabla_mutex[i].num_locks = 0;
-		tabla_mutex[i].num_procesos_bloqueados = 0;
-		tabla_mutex[i].id_proc_bloq = -1;
+		DEPURAR("\tError cerrando el segmento: el proceso %d no tiene abierto ningun segmento en esa direccion\n", p_proc_actual->id);
+		return -1;
 	}
+
+	p_proc_actual->lider->segmentos_abiertos[id_segmento]--;
+	soltar_segmento(id_segmento);
+	return 0;
 }
 
-static int buscar_descriptor_libre()
+static void iniciar_memoria_compartida()
 {
-	for (int i = 0; i != NUM_MUT_PROC; ++i)
+	for (int i = 0; i != NUM_PAGINAS_COMPARTIDAS; ++i)
 	{
-		if (p_proc_actual->descriptores_mutex[i] == NULL)
-		{
-			return i; // Devuelve el numero del descriptor
-		}
+		paginas_compartidas[i] = -1;
+	}
+	for (int i = 0; i != NUM_SEGMENTOS; ++i)
+	{
+		tabla_segmentos[i].usado = 0;
+		tabla_segmentos[i].nombre[0] = '\0';
 	}
-	return -1; // No hay descriptor libre
 }
 
-static int buscar_nombre_mutex(char *nombre_mutex)
+static int reservar_paginas(int num_paginas)
 {
-	for (int i = 0; i != NUM_MUT; ++i)
+	// Primer hueco de paginas libres contiguas suficientemente grande
+	int libres = 0;
+	for (int i = 0; i != NUM_PAGINAS_COMPARTIDAS; ++i)
 	{
-		if (strcmp(tabla_mutex[i].nombre, nombre_mutex) == 0)
+		libres = (paginas_compartidas[i] == -1) ? libres + 1 : 0;
+		if (libres == num_paginas)
 		{
-			return i; // El nombre existe y devuelve su posicion (descriptor) en la tabla de mutex
+			return i - num_paginas + 1;
 		}
 	}
-	return -1; // El nombre no existe
+	return -1;
 }
 
-static int buscar_mutex_libre()
+static void liberar_paginas(int primera, int num_paginas)
 {
-	for (int i = 0; i != NUM_MUT; ++i)
+	for (int i = primera; i != primera + num_paginas; ++i)
 	{
-		if (tabla_mutex[i].estado == MUTEX_ESTADO_LIBRE)
-			return i; // El mutex esta libre y devuelve su posicion en la tabla de mutex
+		paginas_compartidas[i] = -1;
 	}
-	return -1; // No hay mutex libre
 }
 
-static BCP *buscar_procesos_con_mutex(mutex *mut)
+static int buscar_nombre_segmento(char *nombre_segmento)
 {
-	BCP *p_proc = cola_bloqueados_mutex_lock.primero;
-	while (p_proc != NULL)
+	for (int i = 0; i != NUM_SEGMENTOS; ++i)
 	{
-		printk("\t\tID del proceso bloqueado por lock: %d\n", p_proc->id);
-		for (int i = 0; i != NUM_MUT_PROC; ++i)
+		if (tabla_segmentos[i].usado && strcmp(tabla_segmentos[i].nombre, nombre_segmento) == 0)
 		{
-			if (p_proc->descriptores_mutex[i] != NULL)
-			{
-				printk("\t\tEl proceso ID %d tiene un mutex abierto con descriptor %d. ID del proceso bloqueanque: %d\n",
-					   p_proc->id, i, p_proc->descriptores_mutex[i]->id_proc_bloq);
-				if (p_proc->descriptores_mutex[i]->id_proc_bloq == mut->id_proc_bloq)
-				{
-					printk("\t\tEl proceso ID %d fue bloqueado por el mutex %d poseido por %d\n",
-						   p_proc->id, i, p_proc->descriptores_mutex[i]->id_proc_bloq);
-					return p_proc;
-				}
-			}
+			return i;
 		}
-		p_proc = p_proc->siguiente;
 	}
-	return NULL;
+	return -1;
 }
 
-static void unlock(int descriptor, mutex *mutex_unlock)
+static int buscar_segmento_dir(void *dir)
 {
-	BCP *proceso_desbloquear = buscar_procesos_con_mutex(mutex_unlock);
-
-	// Desbloquear el proceso si se ha encontrado
-	if (proceso_desbloquear != NULL)
+	char *inicio = (char *)dir;
+	if (inicio < zona_compartida || inicio >= zona_compartida + sizeof(zona_compartida) ||
+		(inicio - zona_compartida) % TAM_PAGINA != 0)
 	{
-		printk("\tEl proceso %d va a obtener el mutex %s\n", proceso_desbloquear->id, mutex_unlock->nombre);
-		int nivel = fijar_nivel_int(NIVEL_3);
-
-		eliminar_elem(&cola_bloqueados_mutex_lock, proceso_desbloquear);
-		insertar_ultimo(&cola_listos, proceso_desbloquear);
-
-		fijar_nivel_int(nivel);
-
-		int antiguo_id = mutex_unlock->id_proc_bloq;
-
-		mutex_unlock->num_procesos_bloqueados--;
-		mutex_unlock->id_proc_bloq = proceso_desbloquear->id;
-		mutex_unlock->num_locks = 1; // Por si fuera un mutex recursivo
-		printk("\tEl mutex %s que pertenecia al proceso %d ahora pertenece a %d, el cual ha sido desbloqueado\n",
-			   mutex_unlock->nombre, antiguo_id, proceso_desbloquear->id);
+		return -1;
 	}
-	else
+
+	int id_segmento = paginas_compartidas[(inicio - zona_compartida) / TAM_PAGINA];
+	if (id_segmento < 0 || tabla_segmentos[id_segmento].primera_pagina * TAM_PAGINA != inicio - zona_compartida)
 	{
-		printk("\tEl mutex %s no tiene bloqueado otros procesos\n");
-		mutex_unlock->id_proc_bloq = -1;
-		mutex_unlock->estado = MUTEX_ESTADO_CREADO;
+		return -1;
 	}
+	return id_segmento;
 }
 
-static void cerrar(int descriptor, mutex *mutex_cerrar)
+static void soltar_segmento(int id_segmento)
 {
-	printk("\tNumero de procesos bloqueados por el mutex %s: %d\n", mutex_cerrar->nombre, mutex_cerrar->num_procesos_bloqueados);
-	if (mutex_cerrar->num_procesos_bloqueados > 0)
+	segmento *seg = &(tabla_segmentos[id_segmento]);
+	seg->referencias--;
+	DEPURAR("\tEl segmento %s tiene %d referencias\n", seg->nombre, seg->referencias);
+	if (seg->referencias == 0)
 	{
-		printk("\tEl mutex tiene otros procesos bloqueados. Se va a otorgar el mutex a uno de ellos\n");
-		unlock(descriptor, mutex_cerrar);
+		DEPURAR("\tSe libera el segmento %s\n", seg->nombre);
+		liberar_paginas(seg->primera_pagina, seg->num_paginas);
+		seg->usado = 0;
+		seg->nombre[0] = '\0';
 	}
-	else
-	{
-		printk("\tEl mutex no tiene otros procesos bloqueados\n");
-		// Eliminar el mutex y liberar un proceso bloqueado esperando por un mutex
-		strcpy(mutex_cerrar->nombre, "NO MUTEX");
-		mutex_cerrar->estado = MUTEX_ESTADO_LIBRE;
-		mutex_cerrar->tipo = -1;
-		mutex_cerrar->num_locks = 0;
-		mutex_cerrar->num_procesos_bloqueados = 0;
-		mutex_cerrar->id_proc_bloq = -1;
-
-		printk("\tSe va a buscar un mutex bloqueado por SIS_CREAR_MUTEX\n");
-		BCP *p_proc = cola_bloqueados_mutex_libre.primero;
-		if (p_proc != NULL)
-		{
-			printk("\tSe va a desbloquear el proceso %d bloqueado por SIS_CREAR_MUTEX\n", p_proc->id);
-			int nivel = fijar_nivel_int(NIVEL_3);
-
-			eliminar_elem(&cola_bloqueados_mutex_libre, p_proc);
-			insertar_ultimo(&cola_listos, p_proc);
+}
 
-			fijar_nivel_int(nivel);
-		}
-		else
+static void liberar_segmentos()
+{
+	for (int i = 0; i != NUM_SEGMENTOS; ++i)
+	{
+		while (p_proc_actual->lider->segmentos_abiertos[i] > 0)
 		{
-			printk("\tNo se ha encontrado ninguno\n");
+			p_proc_actual->lider->segmentos_abiertos[i]--;
+			soltar_segmento(i);
 		}
 	}
-	p_proc_actual->descriptores_mutex[descriptor] = NULL;
 }
 
 // Lectura de terminal
 int sis_leer_caracter()
 {
-	printk("[SIS_LEER_CARACTER]\n");
+	DEPURAR("[SIS_LEER_CARACTER]\n");
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	// Otro proceso despertado a la vez puede haberse llevado el caracter. La comprobacion y el
+	// bloqueo se hacen sin bajar de NIVEL_3: un caracter que llegara entre ambos no despertaria a nadie
+	while (terminal_sis.elementos == 0)
+	{
+		DEPURAR("\tSe va a bloquear el proceso %d\n", p_proc_actual->id);
+		bloquear(&cola_bloqueados_terminal, -1);
+	}
 
-	// Error de sincronizacion.
+	char caracter = extraer_caracter();
 
-	int nivel_total = fijar_nivel_int(NIVEL_3);
-	int elementos = terminal_sis.elementos;
+	fijar_nivel_int(nivel);
+
+	return (int)caracter;
+}
 
-	if (elementos == 0)
+int sis_leer_caracter_nb()
+{
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	int caracter = -1;
+	if (terminal_sis.elementos > 0)
 	{
-		printk("\tSe va a bloquear el proceso %d\n", p_proc_actual->id);
+		caracter = extraer_caracter();
+	}
 
-		BCP *proc_bloquear = p_proc_actual;
+	fijar_nivel_int(nivel);
+	return caracter;
+}
 
-		eliminar_elem(&cola_listos, proc_bloquear);
-		insertar_ultimo(&cola_bloqueados_terminal, proc_bloquear);
+int sis_obtener_ticks()
+{
+	return ticks_sistema;
+}
 
-		int nivel_regreso = fijar_nivel_int(NIVEL_1);
+int sis_esperar_evento()
+{
+	int ticks = (int)leer_registro(1);
+	int esperar_terminal = (int)leer_registro(2);
 
-		p_proc_actual = planificador();
-		cambio_contexto(&(proc_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
+	// Como en sis_leer_caracter, se comprueba el buffer y se bloquea sin bajar de NIVEL_3
+	int nivel = fijar_nivel_int(NIVEL_3);
+	int hay_caracter = terminal_sis.elementos > 0;
 
-		fijar_nivel_int(nivel_regreso);
+	if (!esperar_terminal && ticks > 0)
+	{
+		// Solo se espera a que venza el plazo
+		bloquear(&cola_bloqueados_plazo, ticks);
+	}
+	else if (esperar_terminal && !hay_caracter && ticks != 0)
+	{
+		// Despierta con el siguiente caracter o al vencer el plazo
+		bloquear(&cola_bloqueados_terminal, (ticks < 0) ? -1 : ticks);
+		hay_caracter = terminal_sis.elementos > 0;
 	}
 
+	fijar_nivel_int(nivel);
+	return hay_caracter;
+}
+
+static char extraer_caracter()
+{
 	int indice = terminal_sis.indice_proc;
 	char caracter = terminal_sis.buffer[indice];
 
+	unsigned long long espera = leer_ciclos() - terminal_sis.llegada[indice];
+	estadisticas_term.leidos++;
+	estadisticas_term.espera_total += espera;
+	if (espera > estadisticas_term.espera_max)
+	{
+		estadisticas_term.espera_max = espera;
+	}
+	estadisticas_term.histograma[cubeta_histograma(espera)]++;
+
 	terminal_sis.elementos--;
-	printk("\tEl proceso %d ha leido el caracter %c del terminal (indice %d). Quedan %d espacios ocupados en el buffer\n",
+	DEPURAR("\tEl proceso %d ha leido el caracter %c del terminal (indice %d). Quedan %d espacios ocupados en el buffer\n",
 		p_proc_actual->id, caracter, indice, terminal_sis.elementos);
 	terminal_sis.indice_proc++;
 	if (terminal_sis.indice_proc >= TAM_BUF_TERM)
 	{
 		terminal_sis.indice_proc = 0;
 	}
+	return caracter;
+}
 
-	fijar_nivel_int(nivel_total);
+static void volcar_estadisticas_terminal()
+{
+	estadisticas_terminal *est = &estadisticas_term;
+	if (est->recibidos == 0)
+	{
+		return;
+	}
 
-	return (int)caracter;
+	printk("[ESTADISTICAS_TERMINAL]\n");
+	printk("\t%d caracteres recibidos, %d perdidos por estar lleno el buffer, %d leidos\n",
+		   est->recibidos, est->perdidos, est->leidos);
+	if (est->leidos != 0)
+	{
+		printk("\tEspera en el buffer: media %llu ciclos, maxima %llu\n",
+			   est->espera_total / est->leidos, est->espera_max);
+	}
 }
 
 static void iniciar_terminal()
@@ -829,6 +3295,15 @@ int main()
 	iniciar_tabla_proc();  // Inicia BCPs de tabla de procesos
 	iniciar_tabla_mutex(); // Inicia mutex
 	iniciar_terminal();	// Inicial el terminal
+	iniciar_tabla_colas(); // Inicia las colas de mensajes
+	iniciar_memoria_compartida(); // Inicia el asignador de memoria compartida
+	iniciar_temporizadores(); // Inicia los temporizadores periodicos
+	iniciar_grupos();		  // Inicia los grupos de cuota de procesador
+	calibrar_reloj();		  // Calibra el contador de ciclos con el reloj CMOS
+	iniciar_pagina_tiempo();  // Publica los ticks y la calibracion a los procesos
+	iniciar_traza();		  // Inicia la traza de eventos
+	iniciar_eventos_externos(); // Graba o reproduce las interrupciones si lo pide el entorno
+	iniciar_muestreo();		  // Prepara el muestreo del contador de programa
 
 	// Crea el proceso inicial
 	if (crear_tarea((void *)"init") < 0)
@@ -35,17 +35,18 @@ int main(){
 	if (abrir_mutex("m4")<0)
 		printf("error abriendo m4. NO DEBE SALIR\n");
 
-	/* Error: ha agotado los descriptores */
+	/* Agotados los NUM_MUT_PROC descriptores del BCP: la tabla de
+	   descriptores del proceso crece */
 	if (abrir_mutex("m5")<0)
-		printf("error abriendo m5. DEBE SALIR\n");
+		printf("error abriendo m5. NO DEBE SALIR\n");
 
 	/* libera un descriptor de mutex (m1) */
 	cerrar_mutex(desc);
 
-	/* Agotado num mutex del sistema. Debe bloquearse */
+	/* Agotados los NUM_MUT mutex iniciales del sistema: la tabla de
+	   mutex crece y no debe bloquearse */
 	if (crear_mutex("m17", 0)<0)
 		printf("error creando m17. NO DEBE SALIR\n");
-	/* se desbloquear cuando se elimine m1 */
 
 	/* intenta crear el mismo mutex: devuelve un error porque ya existe */
 	if (crear_mutex("m17", 0)<0)
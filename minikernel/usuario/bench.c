@@ -0,0 +1,248 @@
+/*
+ * usuario/bench.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Microbenchmarks del kernel: llamada al sistema vacia, escribir segun el
+ * tamanio, lock/unlock sin y con contencion, ping-pong entre dos procesos
+ * cediendose un mutex FIFO, precision de dormir_ticks y creacion y
+ * terminacion de procesos. Los tiempos se miden con obtener_tiempo.
+ *
+ * Cada prueba escribe una linea con el formato
+ *	BENCH nombre operaciones ns_totales ops_por_seg [clave=valor ...]
+ * para poder filtrarla con grep. Para cifras representativas compile el
+ * kernel con DEPURACION=0, que quita los mensajes de cada llamada.
+ */
+
+#include "servicios.h"
+
+#define ITER_VACIA 200000	/* llamadas a obtener_id_pr */
+#define ITER_ESCRIBIR 500	/* llamadas a escribir de cada tamanio */
+#define ITER_MUTEX 200000	/* lock/unlock sin contencion */
+#define ITER_RIVAL 5000	/* lock/unlock de cada proceso con contencion */
+#define ITER_PINGPONG 5000	/* cesiones del mutex de cada proceso */
+#define ITER_DORMIR 50		/* llamadas a dormir_ticks(1) */
+#define ITER_CREAR 200		/* procesos creados */
+#define NUM_RIVALES 3		/* procesos compitiendo por el mutex con main */
+#define TAM_MAX_ESCRIBIR 4096
+
+/* Debe coincidir con bench_rival.c */
+#define CONTENCION 0	/* lock, ceder_cpu, unlock */
+#define PINGPONG 1		/* lock inicial y despues unlock, lock */
+
+struct control {
+	int modo;			/* CONTENCION | PINGPONG */
+	int iteraciones;	/* de cada rival */
+	int listos;			/* rivales con el mutex abierto */
+	int arrancar;		/* main lo pone a 1 cuando estan todos listos */
+	int terminados;
+};
+
+static struct control *ctl;
+static char buffer[TAM_MAX_ESCRIBIR];
+
+static unsigned long long ahora(){
+	unsigned long long ns;
+
+	obtener_tiempo(0, &ns);
+	return ns;
+}
+
+static void informar(char *nombre, int ops, unsigned long long ns){
+	printf("BENCH %s %d %llu %llu", nombre, ops, ns,
+		(ns>0) ? (unsigned long long)ops*1000000000ULL/ns : 0ULL);
+}
+
+static void bench_vacia(){
+	unsigned long long t;
+	int i;
+
+	t=ahora();
+	for (i=0; i<ITER_VACIA; i++)
+		obtener_id_pr();
+	informar("llamada_vacia", ITER_VACIA, ahora()-t);
+	printf("\n");
+}
+
+/* El buffer son retornos de carro para no llenar el terminal de texto */
+static void bench_escribir(char *nombre, int tam){
+	unsigned long long t, ns;
+	int i;
+
+	for (i=0; i<tam; i++)
+		buffer[i]='\r';
+
+	t=ahora();
+	for (i=0; i<ITER_ESCRIBIR; i++)
+		escribir(buffer, tam);
+	ns=ahora()-t;
+
+	printf("\n");
+	informar(nombre, ITER_ESCRIBIR, ns);
+	printf(" bytes_por_seg=%llu\n", (ns>0) ?
+		(unsigned long long)ITER_ESCRIBIR*tam*1000000000ULL/ns : 0ULL);
+}
+
+static void bench_mutex_libre(){
+	unsigned long long t;
+	int m, i;
+
+	if ((m=crear_mutex("bench_m", NO_RECURSIVO))<0){
+		printf("bench: error creando bench_m\n");
+		return;
+	}
+	t=ahora();
+	for (i=0; i<ITER_MUTEX; i++){
+		lock(m);
+		unlock(m);
+	}
+	informar("mutex_sin_contencion", ITER_MUTEX, ahora()-t);
+	printf("\n");
+	cerrar_mutex(m);
+}
+
+/* Crea un mutex bench_m con la politica dada y "rivales" procesos
+   bench_rival que lo abren. Devuelve su descriptor */
+static int preparar_rivales(int modo, int politica, int rivales, int iter){
+	int m, i;
+
+	if ((m=crear_mutex("bench_m", NO_RECURSIVO))<0){
+		printf("bench: error creando bench_m\n");
+		return -1;
+	}
+	politica_mutex(m, politica);
+
+	ctl->modo=modo;
+	ctl->iteraciones=iter;
+	ctl->listos=0;
+	ctl->arrancar=0;
+	ctl->terminados=0;
+	for (i=0; i<rivales; i++)
+		if (crear_proceso("bench_rival")<0)
+			printf("bench: error creando bench_rival\n");
+	while (ctl->listos<rivales)
+		ceder_cpu();
+	return m;
+}
+
+static void esperar_rivales(int rivales){
+	while (ctl->terminados<rivales)
+		ceder_cpu();
+}
+
+/* En un solo procesador un proceso hace todas sus vueltas en su rodaja sin
+   encontrar nunca el mutex ocupado, por lo que cada proceso cede el
+   procesador con el mutex tomado y los demas se bloquean en lock */
+static void bench_mutex_contencion(){
+	unsigned long long t;
+	int m, i;
+
+	if ((m=preparar_rivales(CONTENCION, COMPETITIVO, NUM_RIVALES, ITER_RIVAL))<0)
+		return;
+
+	t=ahora();
+	ctl->arrancar=1;
+	for (i=0; i<ITER_RIVAL; i++){
+		lock(m);
+		ceder_cpu();
+		unlock(m);
+	}
+	esperar_rivales(NUM_RIVALES);
+	informar("mutex_contencion", (NUM_RIVALES+1)*ITER_RIVAL, ahora()-t);
+	printf(" procesos=%d\n", NUM_RIVALES+1);
+	cerrar_mutex(m);
+}
+
+/* main empieza con el mutex FIFO tomado y el rival bloqueado en lock. Cada
+   unlock se lo cede al otro proceso y el lock siguiente bloquea al que lo
+   cedio: cada vuelta es un cambio de contexto en cada sentido */
+static void bench_pingpong(){
+	unsigned long long ns;
+	int m, i;
+
+	if ((m=preparar_rivales(PINGPONG, FIFO, 1, ITER_PINGPONG))<0)
+		return;
+	lock(m);
+	ctl->arrancar=1;
+	ceder_cpu();	/* el rival se bloquea en lock */
+
+	ns=ahora();
+	for (i=0; i<ITER_PINGPONG; i++){
+		unlock(m);
+		lock(m);
+	}
+	ns=ahora()-ns;
+	unlock(m);
+	esperar_rivales(1);
+	informar("pingpong_mutex", 2*ITER_PINGPONG, ns);
+	printf(" ns_por_cesion=%llu\n", ns/(2*ITER_PINGPONG));
+	cerrar_mutex(m);
+}
+
+/* Retraso medio y maximo del despertar respecto al tick pedido. Se
+   sincroniza primero con el reloj para que cada espera sea un tick entero */
+static void bench_dormir(){
+	unsigned long long t, inicio, antes, desfase, total=0, maximo=0;
+	int i;
+
+	dormir_ticks(1);
+	inicio=ahora();
+	antes=inicio;
+	for (i=0; i<ITER_DORMIR; i++){
+		dormir_ticks(1);
+		t=ahora();
+		desfase=t-antes;
+		desfase=(desfase>1000000000ULL/TICK) ? desfase-1000000000ULL/TICK : 1000000000ULL/TICK-desfase;
+		total+=desfase;
+		if (desfase>maximo)
+			maximo=desfase;
+		antes=t;
+	}
+	informar("dormir_ticks", ITER_DORMIR, antes-inicio);
+	printf(" jitter_medio_ns=%llu jitter_max_ns=%llu\n", total/ITER_DORMIR, maximo);
+}
+
+/* Tras crear cada proceso se cede el procesador para que se ejecute y
+   termine antes de seguir */
+static void bench_crear(){
+	unsigned long long t;
+	int i;
+
+	t=ahora();
+	for (i=0; i<ITER_CREAR; i++){
+		if (crear_proceso("bench_vacio")<0){
+			printf("bench: error creando bench_vacio\n");
+			return;
+		}
+		ceder_cpu();
+	}
+	informar("crear_terminar", ITER_CREAR, ahora()-t);
+	printf("\n");
+}
+
+int main(){
+	printf("bench comienza\n");
+
+	if ((ctl=crear_memoria_compartida("bench", sizeof(struct control)))==0){
+		printf("bench: error creando la memoria compartida\n");
+		return 1;
+	}
+
+	bench_vacia();
+	bench_escribir("escribir_1", 1);
+	bench_escribir("escribir_64", 64);
+	bench_escribir("escribir_1024", 1024);
+	bench_escribir("escribir_4096", TAM_MAX_ESCRIBIR);
+	bench_mutex_libre();
+	bench_mutex_contencion();
+	bench_pingpong();
+	bench_dormir();
+	bench_crear();
+
+	cerrar_memoria_compartida(ctl);
+	printf("bench termina\n");
+	return 0;
+}
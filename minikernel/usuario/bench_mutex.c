@@ -0,0 +1,69 @@
+/*
+ * usuario/bench_mutex.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que compara las politicas de cesion de los mutex.
+ * Crea un mutex con la politica POLITICA (FIFO o COMPETITIVO, fijada al
+ * compilar) y varios procesos "martillo" que lo bloquean y desbloquean
+ * continuamente. Con FIFO cada unlock cede el mutex a un proceso que no
+ * se ejecutara hasta su turno de round robin, formando convoyes.
+ *
+ * Los martillos esperan en el mutex, que este programa posee mientras los
+ * crea, y la medida va desde que lo suelta hasta que termina el ultimo.
+ * Al final escribe una linea
+ *	BENCH_MUTEX politica=P procesos=N secciones=N ticks=N ns=N secciones_por_seg=N
+ */
+
+#include "servicios.h"
+#include "bench_mutex.h"
+
+#ifndef POLITICA
+#define POLITICA FIFO
+#endif
+
+#define NUM_MARTILLOS 4	/* numero de procesos que compiten por el mutex */
+
+int main(){
+	int desc, i, ticks;
+	unsigned long long ns;
+	volatile struct medida_martillos *m;
+
+	printf("bench_mutex (%s) comienza\n", (POLITICA == FIFO) ? "FIFO" : "COMPETITIVO");
+
+	if ((desc=crear_mutex("bm", NO_RECURSIVO))<0)
+		printf("error creando bm. NO DEBE SALIR\n");
+
+	if (politica_mutex(desc, POLITICA)<0)
+		printf("error fijando la politica de bm. NO DEBE SALIR\n");
+
+	if ((m=crear_memoria_compartida("bmt", sizeof(struct medida_martillos)))==0){
+		printf("error creando bmt. NO DEBE SALIR\n");
+		return 0;
+	}
+	m->esperados=NUM_MARTILLOS;
+	m->terminados=0;
+
+	lock(desc);
+	for (i=0; i<NUM_MARTILLOS; i++)
+		if (crear_proceso("martillo")<0)
+			printf("Error creando martillo\n");
+	obtener_tiempo(&ticks, &ns);
+	unlock(desc);
+
+	while (m->terminados<NUM_MARTILLOS)
+		dormir_ticks(1);
+
+	ticks=m->ticks_fin-ticks;
+	ns=m->ns_fin-ns;
+	printf("BENCH_MUTEX politica=%s procesos=%d secciones=%d ticks=%d ns=%llu secciones_por_seg=%llu\n",
+		(POLITICA == FIFO) ? "FIFO" : "COMPETITIVO", NUM_MARTILLOS, NUM_MARTILLOS*TOT_ITER,
+		ticks, ns, (ns>0) ? (unsigned long long)NUM_MARTILLOS*TOT_ITER*1000000000ULL/ns : 0ULL);
+
+	cerrar_memoria_compartida((void *)m);
+	printf("bench_mutex termina\n");
+	return 0;
+}
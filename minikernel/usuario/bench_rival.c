@@ -0,0 +1,61 @@
+/*
+ * usuario/bench_rival.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de bench: compite con main por el
+ * mutex bench_m en las pruebas con contencion y de ping-pong.
+ */
+
+#include "servicios.h"
+
+#define CONTENCION 0
+#define PINGPONG 1
+
+struct control {
+	int modo;
+	int iteraciones;
+	int listos;
+	int arrancar;
+	int terminados;
+};
+
+int main(){
+	struct control *ctl;
+	int m, i;
+
+	if ((ctl=abrir_memoria_compartida("bench"))==0){
+		printf("bench_rival: error abriendo bench\n");
+		return 1;
+	}
+	if ((m=abrir_mutex("bench_m"))<0){
+		printf("bench_rival: error abriendo bench_m\n");
+		return 1;
+	}
+
+	__sync_fetch_and_add(&ctl->listos, 1);
+	while (!ctl->arrancar)
+		ceder_cpu();
+
+	if (ctl->modo==CONTENCION)
+		for (i=0; i<ctl->iteraciones; i++){
+			lock(m);
+			ceder_cpu();
+			unlock(m);
+		}
+	else {
+		lock(m);	/* lo tiene main */
+		for (i=1; i<ctl->iteraciones; i++){
+			unlock(m);
+			lock(m);
+		}
+		unlock(m);
+	}
+
+	cerrar_mutex(m);
+	__sync_fetch_and_add(&ctl->terminados, 1);
+	return 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * usuario/bench_vacio.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de bench: termina nada mas empezar,
+ * para medir la creacion y terminacion de procesos. Llama a
+ * terminar_proceso para que se enlace la biblioteca, que aporta el punto
+ * de entrada.
+ */
+
+#include "servicios.h"
+
+int main(){
+	terminar_proceso();
+	return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * usuario/carga.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Generador de carga sintetica para pruebas de escala. Llena la tabla de
+ * procesos con carga_trabajador de cuatro tipos segun el perfil PERFIL
+ * (fijado al compilar): calculo, dormir, mutex y lectura del terminal.
+ * Los trabajadores se ejecutan DURACION ticks y anotan su progreso y sus
+ * latencias en memoria compartida.
+ *
+ * Por cada tipo escribe una linea
+ *	CARGA tipo procesos=N ops=N ops_por_seg=N jain=0.NNN p50_ns=N p99_ns=N max_ns=N
+ * donde jain es el indice de equidad de Jain del progreso de los procesos
+ * del tipo y los percentiles salen del histograma log2 de latencias (cota
+ * superior de la cubeta). Para probar con mas procesos compile todo con
+ * "make clean; make MAX_PROC=100".
+ */
+
+#include "servicios.h"
+#include "carga.h"
+
+#ifndef PERFIL
+#define PERFIL MIXTO
+#endif
+
+/* Porcentaje de procesos de cada tipo y numero de mutex */
+#define MIXTO 0
+#define CPU 1
+#define CERROJOS 2
+
+struct perfil {
+	char *nombre;
+	int porcentaje[NUM_TIPOS];
+	int num_mutex;
+};
+
+static struct perfil perfiles[]={
+	{ "mixto", { 40, 30, 20, 10 }, 4 },
+	{ "cpu", { 100, 0, 0, 0 }, 1 },
+	{ "mutex", { 0, 0, 100, 0 }, 2 },
+};
+
+#define DURACION 300	/* ticks */
+
+static char *nombre_tipo[]={ "calculo", "dormir", "mutex", "terminal" };
+
+/* Valor por debajo del cual queda la fraccion "por_mil" de las latencias,
+   sin pasar de la maxima observada */
+static unsigned long long percentil(int *histograma, int por_mil, unsigned long long maximo){
+	int c, total=0, acumulado=0;
+
+	for (c=0; c<NUM_CUBETAS; c++)
+		total+=histograma[c];
+	if (total==0)
+		return 0;
+	for (c=0; c<NUM_CUBETAS; c++){
+		acumulado+=histograma[c];
+		if ((long long)acumulado*1000>=(long long)total*por_mil)
+			break;
+	}
+	return ((1ULL<<(c+1))<maximo) ? 1ULL<<(c+1) : maximo;
+}
+
+static void informar(struct carga *cg, int num, int tipo, int ticks){
+	unsigned long long suma=0, suma_cuadrados=0, maximo=0, jain;
+	int i, procesos=0;
+
+	for (i=0; i<num; i++)
+		if (cg->tipo[i]==tipo){
+			procesos++;
+			suma+=cg->progreso[i];
+			suma_cuadrados+=(unsigned long long)cg->progreso[i]*cg->progreso[i];
+			if (cg->latencia_max[i]>maximo)
+				maximo=cg->latencia_max[i];
+		}
+	if (procesos==0)
+		return;
+
+	/* (suma x)^2 / (n * suma x^2), en milesimas */
+	jain=(suma_cuadrados>0) ? suma*suma*1000/(procesos*suma_cuadrados) : 1000;
+	printf("CARGA %s procesos=%d ops=%llu ops_por_seg=%llu jain=%llu.%03llu p50_ns=%llu p99_ns=%llu max_ns=%llu\n",
+		nombre_tipo[tipo], procesos, suma, suma*TICK/ticks,
+		jain/1000, jain%1000, percentil(cg->histograma[tipo], 500, maximo),
+		percentil(cg->histograma[tipo], 990, maximo), maximo);
+}
+
+int main(){
+	struct perfil *p=&perfiles[PERFIL];
+	struct carga *cg;
+	int i, t, num, acumulado, inicio, ticks;
+
+	printf("carga (%s) comienza\n", p->nombre);
+
+	if ((cg=crear_memoria_compartida("carga", sizeof(struct carga)))==0){
+		printf("carga: error creando la memoria compartida\n");
+		return 1;
+	}
+	cg->num_mutex=p->num_mutex;
+
+	/* Reparte los huecos de la tabla de procesos, salvo el propio, segun
+	   los porcentajes */
+	num=MAX_TRABAJADORES-1;
+	for (t=0, i=0, acumulado=0; t<NUM_TIPOS; t++){
+		acumulado+=p->porcentaje[t];
+		while (i<num*acumulado/100)
+			cg->tipo[i++]=t;
+	}
+
+	/* Si la tabla esta llena se reintenta una vez, por si init aun no ha
+	   terminado */
+	for (i=0; i<num; i++)
+		if (crear_proceso("carga_trabajador")<0){
+			ceder_cpu();
+			if (crear_proceso("carga_trabajador")<0)
+				break;
+		}
+	num=i;
+	while (cg->listos<num)
+		ceder_cpu();
+
+	inicio=leer_ticks();
+	cg->fin=inicio+DURACION;
+	cg->arrancar=1;
+	while (cg->terminados<num)
+		dormir_ticks(DURACION/10);
+	ticks=leer_ticks()-inicio;
+
+	printf("CARGA total procesos=%d ticks=%d\n", num, ticks);
+	for (t=0; t<NUM_TIPOS; t++)
+		informar(cg, num, t, ticks);
+
+	cerrar_memoria_compartida(cg);
+	printf("carga termina\n");
+	return 0;
+}
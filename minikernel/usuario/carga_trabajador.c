@@ -0,0 +1,99 @@
+/*
+ * usuario/carga_trabajador.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de carga: toma el siguiente hueco
+ * de la memoria compartida "carga" y trabaja segun su tipo hasta el tick
+ * de fin, anotando su progreso y la latencia de cada operacion.
+ */
+
+#include "servicios.h"
+#include "carga.h"
+
+#define TRABAJO_CALCULO 1000000	/* iteraciones de cada bloque de calculo */
+#define TRABAJO_MUTEX 20000		/* iteraciones dentro y fuera de la seccion critica */
+
+/* Las instancias de un mismo programa comparten sus variables globales,
+   por lo que el estado de cada trabajador va en variables locales */
+static void anotar(struct carga *cg, int yo, unsigned long long ns){
+	int c=0;
+
+	while (c<NUM_CUBETAS-1 && ns>=(2ULL<<c))
+		c++;
+	__sync_fetch_and_add(&cg->histograma[cg->tipo[yo]][c], 1);
+	if (ns>cg->latencia_max[yo])
+		cg->latencia_max[yo]=ns;
+}
+
+static void trabajar(int iteraciones){
+	volatile int i;
+
+	for (i=0; i<iteraciones; i++);
+}
+
+/* El primero que llega crea el mutex. Si otro lo crea a la vez, se abre */
+static int mutex_compartido(int n){
+	char nombre[8]="cm";
+	int m;
+
+	nombre[2]='0'+n/10;
+	nombre[3]='0'+n%10;
+	nombre[4]='\0';
+	if ((m=abrir_mutex(nombre))<0 && (m=crear_mutex(nombre, NO_RECURSIVO))<0)
+		m=abrir_mutex(nombre);
+	return m;
+}
+
+int main(){
+	struct carga *cg;
+	unsigned long long t;
+	int yo, m=-1;
+
+	if ((cg=abrir_memoria_compartida("carga"))==0){
+		printf("carga_trabajador: error abriendo carga\n");
+		return 1;
+	}
+	yo=__sync_fetch_and_add(&cg->siguiente, 1);
+	if (cg->tipo[yo]==MUTEX && (m=mutex_compartido(yo%cg->num_mutex))<0)
+		printf("carga_trabajador (%d): error abriendo su mutex\n", yo);
+
+	__sync_fetch_and_add(&cg->listos, 1);
+	while (!cg->arrancar)
+		ceder_cpu();
+
+	while (leer_ticks()-cg->fin<0){
+		switch (cg->tipo[yo]){
+		case CALCULO:
+			t=leer_ns();
+			trabajar(TRABAJO_CALCULO);
+			anotar(cg, yo, leer_ns()-t);
+			break;
+		case DORMIR:
+			t=leer_ns();
+			dormir_ticks(1);
+			anotar(cg, yo, leer_ns()-t);
+			break;
+		case MUTEX:
+			t=leer_ns();
+			lock(m);
+			anotar(cg, yo, leer_ns()-t);
+			trabajar(TRABAJO_MUTEX);
+			unlock(m);
+			trabajar(TRABAJO_MUTEX);
+			break;
+		case TERMINAL:
+			esperar_evento(cg->fin-leer_ticks(), 1);
+			while (leer_caracter_nb()>=0)
+				cg->progreso[yo]++;
+			continue;
+		}
+		cg->progreso[yo]++;
+	}
+
+	__sync_fetch_and_add(&cg->terminados, 1);
+	return 0;
+}
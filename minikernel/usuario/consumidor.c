@@ -0,0 +1,53 @@
+/*
+ * usuario/consumidor.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de las colas de
+ * mensajes: recibe y comprueba los mensajes de prueba_colas
+ */
+
+#include "servicios.h"
+
+#define NUM_MENSAJES 10	/* mensajes recibidos de prueba_colas */
+
+int main(){
+	int cola, i, j, tam;
+	char *buffer;
+
+	printf("consumidor comienza\n");
+
+	if ((cola=crear_cola("cq", 1))<0)
+		printf("error abriendo cq. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_MENSAJES; i++){
+		if ((tam=recibir(cola, (void **)&buffer, BLOQUEANTE))<0){
+			printf("error recibiendo mensaje. NO DEBE APARECER\n");
+			break;
+		}
+		for (j=0; j<tam; j++)
+			if (buffer[j]!=(char)(i+j))
+				break;
+		if (j!=tam)
+			printf("consumidor: mensaje %d corrupto. NO DEBE APARECER\n", i);
+		else
+			printf("consumidor ha recibido el mensaje %d (%d bytes)\n", i, tam);
+
+		if (liberar_buffer(buffer)<0)
+			printf("error liberando buffer. NO DEBE APARECER\n");
+	}
+
+	/* ya no es el propietario del buffer */
+	if (liberar_buffer(buffer)<0)
+		printf("error liberando buffer ya liberado. DEBE APARECER\n");
+
+	/* ni un puntero que no viene de reservar_buffer */
+	if (liberar_buffer(&tam)<0)
+		printf("error liberando puntero cualquiera. DEBE APARECER\n");
+
+	printf("consumidor termina\n");
+	return 0;
+}
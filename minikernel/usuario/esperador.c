@@ -0,0 +1,59 @@
+/*
+ * usuario/esperador.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de trylock y
+ * lock_timeout
+ */
+
+#include "servicios.h"
+
+#define TICKS_ESPERA_CORTA 50	/* medio segundo */
+#define TICKS_ESPERA_LARGA 500	/* cinco segundos */
+#define TICKS_ESPERA_COMPETITIVO 20
+
+int main(){
+	int desc, desc_comp, inicio, res;
+
+	printf("esperador comienza\n");
+
+	if ((desc=abrir_mutex("mt"))<0)
+		printf("error abriendo mt. NO DEBE APARECER\n");
+
+	/* el mutex lo posee prueba_trylock: no debe bloquearse */
+	if (trylock(desc)==MUTEX_OCUPADO)
+		printf("trylock sobre mutex ocupado. DEBE APARECER\n");
+
+	/* prueba_trylock duerme 2 segundos con el mutex: vence el plazo */
+	inicio=obtener_ticks();
+	if (lock_timeout(desc, TICKS_ESPERA_CORTA)==MUTEX_OCUPADO)
+		printf("vence el plazo de lock_timeout tras %d ticks (esperados %d). DEBE APARECER\n",
+			obtener_ticks()-inicio, TICKS_ESPERA_CORTA);
+
+	/* prueba_trylock libera el mutex antes de que venza el plazo */
+	if (lock_timeout(desc, TICKS_ESPERA_LARGA)<0)
+		printf("error en lock_timeout. NO DEBE APARECER\n");
+
+	printf("esperador ha obtenido mt\n");
+
+	if (unlock(desc)<0)
+		printf("error en unlock de mutex. NO DEBE APARECER\n");
+
+	/* prueba_trylock retiene mtc mas que el plazo, soltandolo a ratos */
+	if ((desc_comp=abrir_mutex("mtc"))<0)
+		printf("error abriendo mtc. NO DEBE APARECER\n");
+	inicio=obtener_ticks();
+	res=lock_timeout(desc_comp, TICKS_ESPERA_COMPETITIVO);
+	if (res==MUTEX_OCUPADO && obtener_ticks()-inicio<=TICKS_ESPERA_COMPETITIVO+2)
+		printf("vence a tiempo el plazo de lock_timeout competitivo. DEBE APARECER\n");
+	else
+		printf("lock_timeout competitivo devuelve %d tras %d ticks. NO DEBE APARECER\n",
+			res, obtener_ticks()-inicio);
+
+	printf("esperador termina\n");
+	return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ *  usuario/include/bench_mutex.h
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ *
+ * Fichero de cabecera compartido por bench_mutex y martillo: la medida
+ * se anota en el segmento de memoria compartida "bmt".
+ *
+ */
+
+#ifndef BENCH_MUTEX_H
+#define BENCH_MUTEX_H
+
+#define TOT_ITER 1000	/* secciones criticas de cada martillo */
+
+struct medida_martillos {
+	int esperados;		/* martillos creados por bench_mutex */
+	int terminados;		/* se incrementa despues de anotar el final */
+	int ticks_fin;		/* instante en el que termina el ultimo martillo */
+	unsigned long long ns_fin;
+};
+
+#endif /* BENCH_MUTEX_H */
@@ -0,0 +1,39 @@
+/*
+ *  usuario/include/carga.h
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ *
+ * Fichero de cabecera compartido por carga y carga_trabajador: tipos de
+ * trabajador y memoria compartida "carga" en la que se anotan.
+ *
+ */
+
+#ifndef CARGA_H
+#define CARGA_H
+
+#define CALCULO 0	/* progreso: bloques de calculo. Latencia: duracion del bloque */
+#define DORMIR 1	/* progreso: dormir_ticks(1). Latencia: duracion de la espera */
+#define MUTEX 2		/* progreso: secciones criticas. Latencia: espera en lock */
+#define TERMINAL 3	/* progreso: caracteres leidos. Sin latencia */
+#define NUM_TIPOS 4
+#define NUM_CUBETAS 40
+#define MAX_TRABAJADORES MAX_PROC
+
+struct carga {
+	int arrancar;		/* carga lo pone a 1 cuando estan todos listos */
+	int fin;			/* tick en el que paran los trabajadores */
+	int siguiente;		/* indice del siguiente trabajador que arranca */
+	int listos;
+	int terminados;
+	int num_mutex;		/* los trabajadores MUTEX usan cm<i % num_mutex> */
+	int tipo[MAX_TRABAJADORES];
+	int progreso[MAX_TRABAJADORES];
+	unsigned long long latencia_max[MAX_TRABAJADORES];
+	int histograma[NUM_TIPOS][NUM_CUBETAS];	/* cubeta i: [2^i, 2^(i+1)) ns */
+};
+
+#endif /* CARGA_H */
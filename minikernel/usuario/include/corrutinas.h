@@ -0,0 +1,55 @@
+/*
+ *  usuario/include/corrutinas.h
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ *
+ * Fichero de cabecera de la biblioteca de corrutinas. Las corrutinas se
+ * ejecutan dentro de un unico proceso con un planificador cooperativo en
+ * espacio de usuario: cambiar de corrutina no requiere llamadas al sistema.
+ * Solo cuando ninguna corrutina esta lista el planificador espera en el
+ * kernel a un caracter de terminal o a que venza el primer plazo.
+ *
+ * Hay un unico planificador por imagen: las instancias de un programa, y
+ * los hilos de un proceso, comparten sus variables globales. Solo un
+ * proceso o hilo puede usar la biblioteca a la vez; co_crear,
+ * co_crear_canal y co_ejecutar fallan en los demas hasta que co_ejecutar
+ * termina todas las corrutinas del que la usa.
+ *
+ */
+
+#ifndef CORRUTINAS_H
+#define CORRUTINAS_H
+
+#define MAX_CORRUTINAS 4096		/* corrutinas vivas a la vez */
+#define TAM_PILA_CORRUTINA 16384	/* bytes de pila de cada corrutina */
+
+typedef struct canal_t canal;
+
+/* Crea una corrutina lista para ejecutar funcion(arg). Devuelve su id o
+   -1 si no hay sitio o la biblioteca la usa otro proceso o hilo */
+int co_crear(void (*funcion)(void *), void *arg);
+
+/* Ejecuta las corrutinas hasta que terminan todas. Devuelve -1 si
+   quedan corrutinas bloqueadas para siempre en canales o la biblioteca
+   la usa otro proceso o hilo */
+int co_ejecutar();
+
+/* Operaciones que solo se pueden usar desde una corrutina */
+int co_id();
+void co_ceder();
+void co_dormir(int ticks);
+int co_leer_caracter();
+
+/* Canales con capacidad para "capacidad" mensajes. co_enviar bloquea la
+   corrutina si el canal esta lleno y co_recibir si esta vacio. Fuera de
+   una corrutina solo se pueden usar si no necesitan bloquear */
+canal *co_crear_canal(int capacidad);
+void co_enviar(canal *c, void *dato);
+void *co_recibir(canal *c);
+void co_destruir_canal(canal *c);
+
+#endif /* CORRUTINAS_H */
@@ -49,9 +49,340 @@ int crear_mutex(char *nombre, int tipo);
 int abrir_mutex(char *nombre);
 int lock(unsigned int mutex_id);
 int unlock(unsigned int mutex_id);
-int cerrar_mutex(unsigned int mutex_id);
+int cerrar_mutex(unsigned int mutex_id);	/* -2 si otro hilo del proceso lo posee o espera por el */
 
 int leer_caracter();	// 11/11/2018
 
+/**
+ * Politica seguida al hacer unlock sobre un mutex con procesos bloqueados
+ */
+#define FIFO 0			/* cede el mutex al primer proceso bloqueado */
+#define COMPETITIVO 1	/* despierta al proceso bloqueado, que compite por el mutex */
+int politica_mutex(unsigned int mutex_id, int politica);
+
+/* Devuelven -3 si el mutex esta ocupado (trylock) o vence el plazo (lock_timeout) */
+#define MUTEX_OCUPADO -3
+int trylock(unsigned int mutex_id);
+int lock_timeout(unsigned int mutex_id, int ticks);
+
+/**
+ * Colas de mensajes. Los mensajes son buffers obtenidos con reservar_buffer
+ * que no se copian: enviar cede su propiedad a la cola y recibir al
+ * proceso receptor, que debe liberarlo con liberar_buffer
+ */
+#define NO_BLOQUEANTE 0
+#define BLOQUEANTE 1
+#define COLA_LLENA -3	/* devuelto por enviar no bloqueante */
+#define COLA_VACIA -3	/* devuelto por recibir no bloqueante */
+void *reservar_buffer(int tam);
+int liberar_buffer(void *buffer);
+int crear_cola(char *nombre, int capacidad);	/* crea la cola o devuelve la existente */
+int enviar(unsigned int cola, void *buffer, int tam, int bloqueante);
+int recibir(unsigned int cola, void **buffer, int bloqueante);	/* devuelve el tamanio del mensaje */
+
+/**
+ * Memoria compartida. Devuelven la direccion del segmento o 0 si hay error.
+ * El segmento se libera cuando lo cierran todos los procesos que lo abrieron
+ */
+void *crear_memoria_compartida(char *nombre, int tam);
+void *abrir_memoria_compartida(char *nombre);
+int cerrar_memoria_compartida(void *dir);
+
+/**
+ * Hilos: comparten la imagen, los mutex abiertos y la memoria compartida
+ * del proceso. Devuelve el id del hilo. El hilo termina al volver de funcion
+ */
+int crear_hilo(void (*funcion)(void *), void *arg);
+
+/**
+ * Terminal y reloj sin bloqueo. leer_caracter_nb devuelve -1 si no hay
+ * caracteres. esperar_evento bloquea hasta que pasen "ticks" ticks (-1 sin
+ * limite) o, si "terminal", hasta que haya un caracter. Devuelve 1 si hay
+ * caracteres pendientes
+ */
+int leer_caracter_nb();
+int obtener_ticks();
+int esperar_evento(int ticks, int terminal);
+
+/* Cede el procesador al siguiente proceso listo */
+int ceder_cpu();
+
+/**
+ * Dormir con resolucion de tick (TICK por segundo). dormir_hasta espera
+ * hasta un valor absoluto de obtener_ticks. dormir_ms devuelve -1 si ms
+ * es negativo
+ */
+int dormir_ticks(int ticks);
+int dormir_ms(int ms);
+int dormir_hasta(int tick);
+
+/**
+ * Temporizadores periodicos. Los vencimientos se calculan desde el
+ * anterior, por lo que no acumulan deriva. esperar_temporizador devuelve
+ * el numero de periodos vencidos desde la ultima espera (>1 si se llega tarde)
+ */
+int crear_temporizador(int periodo);
+int esperar_temporizador(unsigned int temporizador);
+int destruir_temporizador(unsigned int temporizador);
+
+/**
+ * Planificacion de tiempo real (EDF). El proceso o hilo pasa a ser una tarea
+ * periodica con "presupuesto" ticks de procesador en cada "periodo" ticks.
+ * Las tareas de tiempo real expulsan a las normales y entre ellas se ejecuta
+ * la de plazo mas cercano. Si se agota el presupuesto la tarea no vuelve a
+ * ejecutarse hasta el siguiente periodo. fijar_tiempo_real(0, 0) vuelve a la
+ * clase normal
+ */
+#define SOBRECARGA -2	/* fijar_tiempo_real: la tarea no cabe en el sistema */
+int fijar_tiempo_real(int periodo, int presupuesto);
+int esperar_periodo();
+int plazos_perdidos();
+
+/**
+ * Grupos con cuota de procesador. Los procesos de un grupo no pueden
+ * consumir mas de "ticks" ticks por ventana de VENTANA_CUOTA ticks (0 sin
+ * limite). Los procesos e hilos nuevos heredan el grupo de su creador
+ */
+int fijar_grupo(int grupo);
+int fijar_cuota(int grupo, int ticks);
+
+/**
+ * Estadisticas de uso del procesador y esperas de un proceso (id -1: el
+ * actual). Debe coincidir con estadisticas_proceso del kernel
+ */
+struct estadisticas {
+	int id;
+	int estado;
+	int ticks_ejecucion;
+	int ticks_listo;		/* en la cola de listos sin ejecutarse */
+	int ticks_dormido;
+	int ticks_bloqueado_mutex;
+	int ticks_bloqueado_terminal;
+	int ticks_aparcado;		/* sin presupuesto de tiempo real o cuota de grupo */
+	int ticks_bloqueado_otros;
+	int cambios_voluntarios;
+	int cambios_involuntarios;
+	int llamadas_sistema;
+	unsigned long long creacion;	/* milisegundos, reloj CMOS */
+};
+int obtener_estadisticas(int id, struct estadisticas *buf);
+
+/**
+ * Instantanea del sistema: tabla de procesos, longitud de las colas del
+ * kernel y mutex en uso, copiados de forma atomica. Los structs deben
+ * coincidir con los instantanea* del kernel
+ */
+#define COLA_LISTOS 0
+#define COLA_DORMIR 1
+#define COLA_MUTEX_LIBRE 2
+#define COLA_MUTEX_LOCK 3
+#define COLA_TERMINAL 4
+#define COLA_PLAZO 5
+#define COLA_TIEMPO_REAL_AGOTADOS 6
+#define COLA_GRUPOS_APARCADOS 7
+#define COLA_OTRA 8		/* colas de mensajes */
+#define NUM_COLAS_SISTEMA 8
+
+struct instantanea_proceso {
+	int id;
+	int estado;
+	int cola;		/* COLA_* o -1 si no esta en ninguna */
+	int lider;
+	int grupo;
+	int tiempo_real;
+	int ticks_restantes;	/* hasta despertar o vencer su plazo. -1 sin plazo */
+	int mutex_esperado;	/* -1 si no espera ninguno */
+};
+
+struct instantanea_mutex {
+	char nombre[8];		/* MAX_NOM_MUT */
+	int id;
+	int estado;
+	int tipo;
+	int politica;
+	int propietario;	/* -1 si no esta bloqueado */
+	int num_locks;
+	int bloqueados;
+	int aperturas;
+};
+
+struct instantanea {
+	int ticks;
+	int proceso_actual;
+	int num_procesos;
+	int num_mutex;
+	int longitud_colas[NUM_COLAS_SISTEMA];
+};
+int obtener_instantanea(struct instantanea *inst,
+	struct instantanea_proceso *procesos, int max_procesos,
+	struct instantanea_mutex *mutex, int max_mutex);
+
+/**
+ * Perfil de contencion de una entrada de la tabla de mutex (el id de
+ * struct instantanea_mutex). Se acumula desde el arranque aunque la
+ * entrada se reutilice. Tiempos en ciclos del procesador. Debe coincidir
+ * con perfil_mutex del kernel
+ */
+#define NUM_CUBETAS_HISTOGRAMA 40
+
+struct perfil_mutex {
+	char nombre[8];		/* ultimo mutex creado en la entrada */
+	int adquisiciones;
+	int adquisiciones_disputadas;	/* tuvieron que bloquearse */
+	int liberaciones;
+	int max_bloqueados;
+	unsigned long long espera_total;	/* de bloquearse en lock a recibir el mutex */
+	unsigned long long espera_max;
+	unsigned long long retencion_total;	/* de recibir el mutex a soltarlo */
+	unsigned long long retencion_max;
+	int histograma_espera[NUM_CUBETAS_HISTOGRAMA];	/* cubeta i: [2^i, 2^(i+1)) */
+	int histograma_retencion[NUM_CUBETAS_HISTOGRAMA];
+};
+int obtener_perfil_mutex(int id, struct perfil_mutex *buf);
+
+/**
+ * Traza de eventos del kernel en un buffer circular. Solo se anotan las
+ * categorias activas en la mascara, fijada al arrancar con la variable de
+ * entorno MINIKERNEL_TRAZA o con fijar_mascara_traza. leer_traza copia los
+ * ultimos eventos en orden cronologico y devuelve cuantos ha copiado. Los
+ * structs deben coincidir con evento_traza y estado_traza del kernel
+ */
+#define TRAZA_PLANIFICACION 0x1
+#define TRAZA_LLAMADAS 0x2
+#define TRAZA_ESPERAS 0x4
+#define TRAZA_INTERRUPCIONES 0x8
+#define TRAZA_TODAS 0xf
+
+#define TRAZA_CAMBIO_CONTEXTO 0	/* dato1: saliente, dato2: entrante */
+#define TRAZA_ENTRADA_LLAMADA 1	/* dato1: servicio */
+#define TRAZA_SALIDA_LLAMADA 2	/* dato1: servicio, dato2: resultado */
+#define TRAZA_BLOQUEO 3		/* dato1: COLA_* */
+#define TRAZA_DESPERTAR 4	/* dato1: proceso despertado */
+#define TRAZA_INTERRUPCION 5	/* dato1: vector */
+
+#define TAM_TRAZA 4096
+
+struct evento_traza {
+	unsigned long long ciclos;
+	int tipo;
+	int proceso;		/* en ejecucion, -1 si ninguno */
+	int dato1;
+	int dato2;
+};
+
+struct estado_traza {
+	int mascara;
+	unsigned int eventos;	/* anotados desde el arranque */
+	unsigned long long ciclos_inicio;
+	unsigned long long ciclos_por_ms;	/* calibrado con el reloj CMOS al arrancar */
+};
+int fijar_mascara_traza(int mascara);
+int leer_traza(struct evento_traza *eventos, int max_eventos, struct estado_traza *estado);
+
+/**
+ * Perfil de un servicio (numero de minikernel/include/llamsis.h): llamadas
+ * completadas y su duracion en ciclos, incluido el tiempo bloqueado. id es
+ * un proceso, -1 el actual o PERFIL_SISTEMA para el total desde el
+ * arranque. Devuelve -1 si el kernel se compilo sin PERFIL_LLAMADAS. Debe
+ * coincidir con perfil_llamada del kernel
+ */
+#define PERFIL_SISTEMA -2
+
+struct perfil_llamada {
+	int llamadas;
+	unsigned long long ciclos_total;
+	unsigned long long ciclos_min;
+	unsigned long long ciclos_max;
+	int histograma[NUM_CUBETAS_HISTOGRAMA];	/* cubeta i: [2^i, 2^(i+1)) */
+};
+int obtener_perfil_llamada(int servicio, int id, struct perfil_llamada *buf);
+
+/**
+ * Muestreo del contador de programa. Con fijar_muestreo(n) el kernel anota
+ * cada n ticks donde estaba ejecutando el proceso interrumpido, hasta
+ * NUM_MUESTRAS por proceso (0 desactiva). leer_muestras devuelve las de un
+ * proceso vivo (-1 el actual) y resolver_direccion traduce una direccion a
+ * "funcion (imagen)" con los simbolos exportados de la imagen: las
+ * funciones static se atribuyen a la funcion exportada anterior
+ */
+#define NUM_MUESTRAS 512
+
+int fijar_muestreo(int periodo);
+int leer_muestras(int id, void **pcs, int max_muestras, int *perdidas);
+int resolver_direccion(void *pc, char *nombre, int tam);
+
+/**
+ * Latencias de planificacion: ciclos desde que un proceso pasa a listo
+ * hasta que el planificador lo elige, segun el motivo, y procesos
+ * esperando a ejecutar en cada tick. obtener_latencias devuelve el tick
+ * actual y, si "reiniciar", pone los contadores a cero. Debe coincidir con
+ * latencias_planificacion del kernel
+ */
+#define CAUSA_NUEVO 0
+#define CAUSA_DORMIR 1
+#define CAUSA_TERMINAL 2
+#define CAUSA_MUTEX 3
+#define CAUSA_PLAZO 4		/* vence una espera limitada */
+#define CAUSA_TIEMPO_REAL 5
+#define CAUSA_CUOTA 6
+#define CAUSA_EXPULSION 7	/* fin de rodaja o ceder_cpu */
+#define CAUSA_OTRA 8		/* colas de mensajes */
+#define NUM_CAUSAS_LISTO 9
+
+#ifndef MAX_PROC
+#define MAX_PROC 10		/* debe coincidir con minikernel/include/const.h */
+#endif
+#define TICK 100		/* interrupciones de reloj por segundo. Debe coincidir con minikernel/include/const.h */
+#define TAM_HISTORIAL_LISTOS 1024
+
+struct latencias {
+	int despachos[NUM_CAUSAS_LISTO];
+	unsigned long long latencia_total[NUM_CAUSAS_LISTO];
+	unsigned long long latencia_max[NUM_CAUSAS_LISTO];
+	int histograma[NUM_CAUSAS_LISTO][NUM_CUBETAS_HISTOGRAMA];
+	int ticks;
+	int ticks_con_longitud[MAX_PROC+1];
+	int historial_listos[TAM_HISTORIAL_LISTOS];	/* tick t en t % TAM_HISTORIAL_LISTOS */
+};
+int obtener_latencias(struct latencias *buf, int reiniciar);
+
+/**
+ * Reloj de alta resolucion: ticks y nanosegundos desde el arranque, estos
+ * segun el contador de ciclos calibrado con el reloj CMOS. Cualquiera de
+ * los dos punteros puede ser nulo
+ */
+int obtener_tiempo(int *ticks, unsigned long long *ns);
+
+/**
+ * Pagina de tiempo: el kernel la actualiza en cada tick y los procesos la
+ * leen sin llamadas al sistema, en solo lectura. leer_ticks y leer_ns
+ * equivalen a obtener_tiempo sin entrar en el kernel, salvo la primera vez
+ * que piden la pagina. Debe coincidir con pagina_tiempo del kernel
+ */
+struct pagina_tiempo {
+	volatile int ticks;
+	unsigned long long ciclos_arranque;
+	unsigned long long ciclos_por_ms;
+};
+const struct pagina_tiempo *obtener_pagina_tiempo();
+int leer_ticks();
+unsigned long long leer_ns();
+
+/**
+ * Estadisticas del terminal: caracteres recibidos, perdidos por estar lleno
+ * el buffer del kernel y leidos, con los ciclos que pasan en el buffer
+ * hasta que se leen. Si "reiniciar" se ponen a cero. Debe coincidir con
+ * estadisticas_terminal del kernel
+ */
+struct estadisticas_terminal {
+	int recibidos;
+	int perdidos;
+	int leidos;
+	unsigned long long espera_total;
+	unsigned long long espera_max;
+	int histograma[NUM_CUBETAS_HISTOGRAMA];	/* cubeta i: [2^i, 2^(i+1)) */
+};
+int obtener_estadisticas_terminal(struct estadisticas_terminal *buf, int reiniciar);
+
 #endif /* SERVICIOS_H */
 
@@ -0,0 +1,51 @@
+/*
+ * usuario/lector_terminal.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario para medir la entrada del terminal con
+ * herramientas/inyector. Lee caracteres hasta que pasa un segundo sin
+ * recibir ninguno, trabajando TRABAJO iteraciones por caracter, y escribe
+ *	TERMINAL recibidos=N perdidos=N leidos=N espera_media_ns=N espera_max_ns=N
+ * con las estadisticas del kernel. Con TRABAJO alto el lector no da
+ * abasto y el buffer del kernel se llena.
+ */
+
+#include "servicios.h"
+
+#ifndef TRABAJO
+#define TRABAJO 0
+#endif
+
+static unsigned long long a_ns(unsigned long long ciclos, unsigned long long ciclos_por_ms){
+	return (ciclos_por_ms>0) ? ciclos*1000000ULL/ciclos_por_ms : 0;
+}
+
+int main(){
+	const struct pagina_tiempo *pag;
+	struct estadisticas_terminal est;
+	unsigned long long cpm=0;
+	volatile int j;
+	int leidos=0;
+
+	printf("lector_terminal comienza\n");
+	if ((pag=obtener_pagina_tiempo())!=0)
+		cpm=pag->ciclos_por_ms;
+
+	/* el primer caracter se espera sin limite */
+	while (leidos==0 || esperar_evento(TICK, 1)){
+		leer_caracter();
+		leidos++;
+		for (j=0; j<TRABAJO; j++);
+	}
+
+	obtener_estadisticas_terminal(&est, 0);
+	printf("TERMINAL recibidos=%d perdidos=%d leidos=%d espera_media_ns=%llu espera_max_ns=%llu\n",
+		est.recibidos, est.perdidos, est.leidos,
+		a_ns(est.leidos ? est.espera_total/est.leidos : 0, cpm), a_ns(est.espera_max, cpm));
+	printf("lector_terminal termina\n");
+	return 0;
+}
@@ -0,0 +1,408 @@
+/*
+ *  usuario/lib/corrutinas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ *
+ * Biblioteca de corrutinas (varias corrutinas sobre un proceso). El cambio
+ * de contexto se hace en espacio de usuario guardando solo los registros
+ * que preserva una llamada a funcion. Las pilas se reservan con
+ * reservar_buffer y se reutilizan al crear nuevas corrutinas.
+ * Como las usa un solo proceso o hilo a la vez (ver corrutinas.h), al
+ * terminar co_ejecutar se liberan: son buffers de ese proceso.
+ *
+ */
+
+#include "servicios.h"
+#include "corrutinas.h"
+
+#define CO_LIBRE 0
+#define CO_LISTA 1
+#define CO_DORMIDA 2		/* espera en co_dormir */
+#define CO_TECLADO 3		/* espera en co_leer_caracter */
+#define CO_CANAL 4			/* espera en co_enviar o co_recibir */
+#define CO_TERMINADA 5
+
+/* cambios de corrutina entre dos consultas de eventos al kernel */
+#define INTERVALO_EVENTOS 64
+
+/*
+ * Cambio de contexto
+ */
+#if defined(__x86_64__)
+
+typedef void *contexto;		/* puntero de pila con los registros guardados */
+
+void co_cambiar(contexto *guardar, contexto cargar) __attribute__((visibility("hidden")));
+
+/* Guarda los registros preservados por el llamado en la pila actual, cambia
+   de pila y los recupera de la nueva. ret continua en la otra corrutina */
+__asm__(
+	".text\n"
+	".globl co_cambiar\n"
+	".hidden co_cambiar\n"
+	".type co_cambiar, @function\n"
+	"co_cambiar:\n"
+	"\tpushq %rbp\n"
+	"\tpushq %rbx\n"
+	"\tpushq %r12\n"
+	"\tpushq %r13\n"
+	"\tpushq %r14\n"
+	"\tpushq %r15\n"
+	"\tmovq %rsp, (%rdi)\n"
+	"\tmovq %rsi, %rsp\n"
+	"\tpopq %r15\n"
+	"\tpopq %r14\n"
+	"\tpopq %r13\n"
+	"\tpopq %r12\n"
+	"\tpopq %rbx\n"
+	"\tpopq %rbp\n"
+	"\tret\n"
+	".size co_cambiar, .-co_cambiar\n");
+
+#else
+
+#include <ucontext.h>
+
+typedef ucontext_t contexto;
+
+#endif
+
+typedef struct corrutina_t corrutina;
+
+struct corrutina_t
+{
+	int id;
+	int estado;				/* CO_LIBRE | CO_LISTA | CO_DORMIDA | CO_TECLADO | CO_CANAL | CO_TERMINADA */
+	contexto regs;			/* contexto guardado mientras no se ejecuta */
+	void *pila;				/* se conserva al liberar la corrutina para reutilizarla */
+	void (*funcion)(void *);
+	void *arg;
+	int despertar;			/* tick en el que termina co_dormir */
+	int caracter;			/* caracter entregado por el planificador en co_leer_caracter */
+	corrutina *siguiente;	/* lista en la que esta la corrutina */
+};
+
+typedef struct lista_co_t
+{
+	corrutina *primero;
+	corrutina *ultimo;
+} lista_co;
+
+struct canal_t
+{
+	int capacidad;
+	int primero;			/* indice del dato mas antiguo */
+	int num_datos;
+	void **datos;			/* buffer circular que sigue al canal */
+	lista_co emisores;		/* corrutinas esperando a que haya hueco */
+	lista_co receptores;	/* corrutinas esperando a que haya datos */
+};
+
+static corrutina tabla_co[MAX_CORRUTINAS];
+static corrutina *actual = 0;		/* corrutina en ejecucion */
+static contexto regs_planificador;	/* contexto de co_ejecutar */
+static lista_co listas = { 0, 0 };
+static lista_co dormidas = { 0, 0 };
+static lista_co teclado = { 0, 0 };
+static int num_vivas = 0;
+static int siguiente_libre = 0;		/* por donde empezar a buscar una entrada libre */
+static int propietario = -1;		/* id del proceso o hilo que usa la biblioteca. -1 si ninguno */
+
+/* Devuelve -1 si la biblioteca la usa otro proceso o hilo */
+static int reclamar()
+{
+	int id = obtener_id_pr();
+
+	if (propietario == id || __sync_bool_compare_and_swap(&propietario, -1, id))
+		return 0;
+	return -1;
+}
+
+/* Al terminar todas las corrutinas otro proceso puede usar la biblioteca */
+static void soltar()
+{
+	int i;
+
+	for (i = 0; i < MAX_CORRUTINAS; i++)
+		if (tabla_co[i].pila){
+			liberar_buffer(tabla_co[i].pila);
+			tabla_co[i].pila = 0;
+		}
+	siguiente_libre = 0;
+	propietario = -1;
+}
+
+static void insertar(lista_co *lista, corrutina *co)
+{
+	co->siguiente = 0;
+	if (lista->ultimo)
+		lista->ultimo->siguiente = co;
+	else
+		lista->primero = co;
+	lista->ultimo = co;
+}
+
+static corrutina *sacar(lista_co *lista)
+{
+	corrutina *co = lista->primero;
+	if (co){
+		lista->primero = co->siguiente;
+		if (lista->primero == 0)
+			lista->ultimo = 0;
+	}
+	return co;
+}
+
+static void cambiar(contexto *guardar, contexto *cargar)
+{
+#if defined(__x86_64__)
+	co_cambiar(guardar, *cargar);
+#else
+	swapcontext(guardar, cargar);
+#endif
+}
+
+/* Devuelve el control al planificador. La corrutina ya esta en la lista
+   que corresponda a su espera */
+static void suspender()
+{
+	cambiar(&(actual->regs), &regs_planificador);
+}
+
+static void despertar_uno(lista_co *lista)
+{
+	corrutina *co = sacar(lista);
+	if (co){
+		co->estado = CO_LISTA;
+		insertar(&listas, co);
+	}
+}
+
+static void arranque()
+{
+	actual->funcion(actual->arg);
+	actual->estado = CO_TERMINADA;
+	suspender();	/* no se vuelve a planificar */
+}
+
+static void preparar_contexto(corrutina *co)
+{
+#if defined(__x86_64__)
+	int i;
+	void **sp = (void **)(((unsigned long)co->pila + TAM_PILA_CORRUTINA) & ~15UL);
+
+	*--sp = 0;					/* retorno de arranque, que nunca vuelve */
+	*--sp = (void *)arranque;	/* retorno de co_cambiar */
+	for (i = 0; i < 6; i++)
+		*--sp = 0;				/* rbp, rbx, r12 - r15 */
+	co->regs = sp;
+#else
+	getcontext(&(co->regs));
+	co->regs.uc_stack.ss_sp = co->pila;
+	co->regs.uc_stack.ss_size = TAM_PILA_CORRUTINA;
+	co->regs.uc_link = 0;
+	makecontext(&(co->regs), arranque, 0);
+#endif
+}
+
+int co_crear(void (*funcion)(void *), void *arg)
+{
+	int i, id;
+	corrutina *co;
+
+	if (reclamar() < 0)
+		return -1;
+
+	for (i = 0; i < MAX_CORRUTINAS; i++){
+		id = (siguiente_libre + i) % MAX_CORRUTINAS;
+		if (tabla_co[id].estado == CO_LIBRE)
+			break;
+	}
+	if (i == MAX_CORRUTINAS)
+		return -1;
+
+	co = &tabla_co[id];
+	if (co->pila == 0 && (co->pila = reservar_buffer(TAM_PILA_CORRUTINA)) == 0)
+		return -1;
+
+	co->id = id;
+	co->funcion = funcion;
+	co->arg = arg;
+	co->estado = CO_LISTA;
+	preparar_contexto(co);
+	insertar(&listas, co);
+	num_vivas++;
+	siguiente_libre = (id + 1) % MAX_CORRUTINAS;
+	return id;
+}
+
+/* Despierta las corrutinas cuyo plazo ha vencido y reparte los caracteres
+   del terminal. Si "esperar" y no queda ninguna lista, espera en el kernel.
+   Devuelve -1 si no hay nada que pueda despertar a las corrutinas */
+static int atender_eventos(int esperar)
+{
+	corrutina *co, *anterior, *siguiente;
+	int ahora, plazo, caracter;
+
+	for (;;){
+		if (dormidas.primero){
+			ahora = obtener_ticks();
+			plazo = -1;
+			anterior = 0;
+			for (co = dormidas.primero; co; co = siguiente){
+				siguiente = co->siguiente;
+				if (co->despertar - ahora <= 0){
+					if (anterior)
+						anterior->siguiente = siguiente;
+					else
+						dormidas.primero = siguiente;
+					if (dormidas.ultimo == co)
+						dormidas.ultimo = anterior;
+					co->estado = CO_LISTA;
+					insertar(&listas, co);
+				}
+				else {
+					if (plazo < 0 || co->despertar - ahora < plazo)
+						plazo = co->despertar - ahora;
+					anterior = co;
+				}
+			}
+		}
+		else
+			plazo = -1;
+
+		while (teclado.primero && (caracter = leer_caracter_nb()) >= 0){
+			co = sacar(&teclado);
+			co->caracter = caracter;
+			co->estado = CO_LISTA;
+			insertar(&listas, co);
+		}
+
+		if (!esperar || listas.primero)
+			return 0;
+		if (plazo < 0 && teclado.primero == 0)
+			return -1;	/* todas esperan en canales */
+
+		esperar_evento(plazo, teclado.primero != 0);
+	}
+}
+
+int co_ejecutar()
+{
+	corrutina *co;
+	int cambios = 0;
+
+	if (reclamar() < 0)
+		return -1;
+
+	while (num_vivas > 0){
+		if (listas.primero == 0 || ++cambios % INTERVALO_EVENTOS == 0)
+			if (atender_eventos(listas.primero == 0) < 0)
+				return -1;
+
+		co = sacar(&listas);
+		actual = co;
+		cambiar(&regs_planificador, &(co->regs));
+		actual = 0;
+
+		if (co->estado == CO_TERMINADA){
+			co->estado = CO_LIBRE;
+			num_vivas--;
+		}
+	}
+	soltar();
+	return 0;
+}
+
+int co_id()
+{
+	return actual->id;
+}
+
+void co_ceder()
+{
+	actual->estado = CO_LISTA;
+	insertar(&listas, actual);
+	suspender();
+}
+
+void co_dormir(int ticks)
+{
+	if (ticks <= 0){
+		co_ceder();
+		return;
+	}
+	actual->despertar = obtener_ticks() + ticks;
+	actual->estado = CO_DORMIDA;
+	insertar(&dormidas, actual);
+	suspender();
+}
+
+int co_leer_caracter()
+{
+	int caracter;
+
+	/* si ya hay corrutinas esperando se respeta su orden */
+	if (teclado.primero == 0 && (caracter = leer_caracter_nb()) >= 0)
+		return caracter;
+
+	actual->estado = CO_TECLADO;
+	insertar(&teclado, actual);
+	suspender();
+	return actual->caracter;
+}
+
+canal *co_crear_canal(int capacidad)
+{
+	canal *c;
+
+	if (capacidad < 1 || reclamar() < 0)
+		return 0;
+	if ((c = reservar_buffer(sizeof(canal) + capacidad * sizeof(void *))) == 0)
+		return 0;
+
+	c->capacidad = capacidad;
+	c->primero = 0;
+	c->num_datos = 0;
+	c->datos = (void **)(c + 1);
+	c->emisores.primero = c->emisores.ultimo = 0;
+	c->receptores.primero = c->receptores.ultimo = 0;
+	return c;
+}
+
+void co_enviar(canal *c, void *dato)
+{
+	while (c->num_datos == c->capacidad){
+		actual->estado = CO_CANAL;
+		insertar(&(c->emisores), actual);
+		suspender();
+	}
+	c->datos[(c->primero + c->num_datos) % c->capacidad] = dato;
+	c->num_datos++;
+	despertar_uno(&(c->receptores));
+}
+
+void *co_recibir(canal *c)
+{
+	void *dato;
+
+	while (c->num_datos == 0){
+		actual->estado = CO_CANAL;
+		insertar(&(c->receptores), actual);
+		suspender();
+	}
+	dato = c->datos[c->primero];
+	c->primero = (c->primero + 1) % c->capacidad;
+	c->num_datos--;
+	despertar_uno(&(c->emisores));
+	return dato;
+}
+
+void co_destruir_canal(canal *c)
+{
+	liberar_buffer(c);
+}
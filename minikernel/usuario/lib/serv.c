@@ -90,4 +90,279 @@ int cerrar_mutex(unsigned int mutex_id)
 int leer_caracter()
 {
 	return llamsis(LEER_CARACTER, 0);
-}
\ No newline at end of file
+}
+
+int politica_mutex(unsigned int mutex_id, int politica)
+{
+	return llamsis(POLITICA_MUTEX, 2, (long)mutex_id, (long)politica);
+}
+
+int trylock(unsigned int mutex_id)
+{
+	return llamsis(TRYLOCK_MUTEX, 1, (long)mutex_id);
+}
+
+int lock_timeout(unsigned int mutex_id, int ticks)
+{
+	return llamsis(LOCK_TIMEOUT_MUTEX, 2, (long)mutex_id, (long)ticks);
+}
+
+/**
+ * Colas de mensajes
+ */
+void *reservar_buffer(int tam)
+{
+	void *buffer;
+	if (llamsis(RESERVAR_BUFFER, 2, (long)tam, (long)&buffer) < 0)
+		return (void *)0;
+	return buffer;
+}
+
+int liberar_buffer(void *buffer)
+{
+	return llamsis(LIBERAR_BUFFER, 1, (long)buffer);
+}
+
+int crear_cola(char *nombre, int capacidad)
+{
+	return llamsis(CREAR_COLA, 2, (long)nombre, (long)capacidad);
+}
+
+int enviar(unsigned int cola, void *buffer, int tam, int bloqueante)
+{
+	return llamsis(ENVIAR, 4, (long)cola, (long)buffer, (long)tam, (long)bloqueante);
+}
+
+int recibir(unsigned int cola, void **buffer, int bloqueante)
+{
+	return llamsis(RECIBIR, 3, (long)cola, (long)buffer, (long)bloqueante);
+}
+
+/**
+ * Memoria compartida
+ */
+void *crear_memoria_compartida(char *nombre, int tam)
+{
+	void *dir;
+	if (llamsis(CREAR_MEMORIA_COMPARTIDA, 3, (long)nombre, (long)tam, (long)&dir) < 0)
+		return (void *)0;
+	return dir;
+}
+
+void *abrir_memoria_compartida(char *nombre)
+{
+	void *dir;
+	if (llamsis(ABRIR_MEMORIA_COMPARTIDA, 2, (long)nombre, (long)&dir) < 0)
+		return (void *)0;
+	return dir;
+}
+
+int cerrar_memoria_compartida(void *dir)
+{
+	return llamsis(CERRAR_MEMORIA_COMPARTIDA, 1, (long)dir);
+}
+
+/**
+ * Hilos. El kernel arranca cada hilo en inicio_hilo, que recupera la
+ * funcion y el argumento del hilo. Al volver, start termina el hilo
+ */
+static void inicio_hilo()
+{
+	void (*funcion)(void *);
+	void *arg;
+
+	if (llamsis(DATOS_HILO, 2, (long)&funcion, (long)&arg) == 0)
+		funcion(arg);
+}
+
+int crear_hilo(void (*funcion)(void *), void *arg)
+{
+	return llamsis(CREAR_HILO, 3, (long)inicio_hilo, (long)funcion, (long)arg);
+}
+
+/**
+ * Terminal y reloj sin bloqueo
+ */
+int leer_caracter_nb()
+{
+	return llamsis(LEER_CARACTER_NB, 0);
+}
+
+int obtener_ticks()
+{
+	return llamsis(OBTENER_TICKS, 0);
+}
+
+int esperar_evento(int ticks, int terminal)
+{
+	return llamsis(ESPERAR_EVENTO, 2, (long)ticks, (long)terminal);
+}
+
+int ceder_cpu()
+{
+	return llamsis(CEDER_CPU, 0);
+}
+
+/**
+ * Dormir con resolucion de tick y temporizadores periodicos
+ */
+int dormir_ticks(int ticks)
+{
+	return llamsis(DORMIR_TICKS, 1, (long)ticks);
+}
+
+int dormir_ms(int ms)
+{
+	return llamsis(DORMIR_MS, 1, (long)ms);
+}
+
+int dormir_hasta(int tick)
+{
+	return llamsis(DORMIR_HASTA, 1, (long)tick);
+}
+
+int crear_temporizador(int periodo)
+{
+	return llamsis(CREAR_TEMPORIZADOR, 1, (long)periodo);
+}
+
+int esperar_temporizador(unsigned int temporizador)
+{
+	return llamsis(ESPERAR_TEMPORIZADOR, 1, (long)temporizador);
+}
+
+int destruir_temporizador(unsigned int temporizador)
+{
+	return llamsis(DESTRUIR_TEMPORIZADOR, 1, (long)temporizador);
+}
+
+/**
+ * Planificacion de tiempo real (EDF)
+ */
+int fijar_tiempo_real(int periodo, int presupuesto)
+{
+	return llamsis(FIJAR_TIEMPO_REAL, 2, (long)periodo, (long)presupuesto);
+}
+
+int esperar_periodo()
+{
+	return llamsis(ESPERAR_PERIODO, 0);
+}
+
+int plazos_perdidos()
+{
+	return llamsis(PLAZOS_PERDIDOS, 0);
+}
+
+/**
+ * Grupos con cuota de procesador
+ */
+int fijar_grupo(int grupo)
+{
+	return llamsis(FIJAR_GRUPO, 1, (long)grupo);
+}
+
+int fijar_cuota(int grupo, int ticks)
+{
+	return llamsis(FIJAR_CUOTA, 2, (long)grupo, (long)ticks);
+}
+
+int obtener_estadisticas(int id, struct estadisticas *buf)
+{
+	return llamsis(OBTENER_ESTADISTICAS, 2, (long)id, (long)buf);
+}
+
+int obtener_instantanea(struct instantanea *inst,
+	struct instantanea_proceso *procesos, int max_procesos,
+	struct instantanea_mutex *mutex, int max_mutex)
+{
+	return llamsis(OBTENER_INSTANTANEA, 5, (long)inst, (long)procesos,
+		(long)max_procesos, (long)mutex, (long)max_mutex);
+}
+
+int obtener_perfil_mutex(int id, struct perfil_mutex *buf)
+{
+	return llamsis(OBTENER_PERFIL_MUTEX, 2, (long)id, (long)buf);
+}
+
+int fijar_mascara_traza(int mascara)
+{
+	return llamsis(FIJAR_MASCARA_TRAZA, 1, (long)mascara);
+}
+
+int leer_traza(struct evento_traza *eventos, int max_eventos, struct estado_traza *estado)
+{
+	return llamsis(LEER_TRAZA, 3, (long)eventos, (long)max_eventos, (long)estado);
+}
+
+int obtener_perfil_llamada(int servicio, int id, struct perfil_llamada *buf)
+{
+	return llamsis(OBTENER_PERFIL_LLAMADA, 3, (long)servicio, (long)id, (long)buf);
+}
+
+int fijar_muestreo(int periodo)
+{
+	return llamsis(FIJAR_MUESTREO, 1, (long)periodo);
+}
+
+int leer_muestras(int id, void **pcs, int max_muestras, int *perdidas)
+{
+	return llamsis(LEER_MUESTRAS, 4, (long)id, (long)pcs, (long)max_muestras, (long)perdidas);
+}
+
+int resolver_direccion(void *pc, char *nombre, int tam)
+{
+	return llamsis(RESOLVER_DIRECCION, 3, (long)pc, (long)nombre, (long)tam);
+}
+
+int obtener_latencias(struct latencias *buf, int reiniciar)
+{
+	return llamsis(OBTENER_LATENCIAS, 2, (long)buf, (long)reiniciar);
+}
+
+int obtener_tiempo(int *ticks, unsigned long long *ns)
+{
+	return llamsis(OBTENER_TIEMPO, 2, (long)ticks, (long)ns);
+}
+
+int obtener_estadisticas_terminal(struct estadisticas_terminal *buf, int reiniciar)
+{
+	return llamsis(OBTENER_ESTADISTICAS_TERMINAL, 2, (long)buf, (long)reiniciar);
+}
+
+/* Se pide al kernel una vez por imagen */
+static const struct pagina_tiempo *pagina_tiempo = 0;
+
+const struct pagina_tiempo *obtener_pagina_tiempo()
+{
+	const struct pagina_tiempo *dir;
+	if (pagina_tiempo == 0 && llamsis(OBTENER_PAGINA_TIEMPO, 1, (long)&dir) == 0)
+		pagina_tiempo = dir;
+	return pagina_tiempo;
+}
+
+int leer_ticks()
+{
+	if (obtener_pagina_tiempo() == 0)
+		return obtener_ticks();
+	return pagina_tiempo->ticks;
+}
+
+/* Mismo calculo que ns_desde_arranque en el kernel */
+unsigned long long leer_ns()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int bajo, alto;
+	unsigned long long ciclos, por_ms;
+
+	if (obtener_pagina_tiempo() != 0){
+		__asm__ __volatile__("rdtsc" : "=a"(bajo), "=d"(alto));
+		ciclos = (((unsigned long long)alto << 32) | bajo) - pagina_tiempo->ciclos_arranque;
+		por_ms = pagina_tiempo->ciclos_por_ms;
+		return (ciclos / por_ms) * 1000000ULL + (ciclos % por_ms) * 1000000ULL / por_ms;
+	}
+#endif
+	unsigned long long ns;
+	obtener_tiempo(0, &ns);
+	return ns;
+}
@@ -0,0 +1,60 @@
+/*
+ * usuario/martillo.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de bench_mutex: bloquea y
+ * desbloquea el mutex "bm" continuamente, trabajando tanto dentro
+ * como fuera de la seccion critica. El ultimo en terminar anota el
+ * instante final en el segmento "bmt".
+ */
+
+#include "servicios.h"
+#include "bench_mutex.h"
+
+#define TRABAJO 20000	/* iteraciones de trabajo dentro y fuera del mutex */
+
+int main(){
+	int desc, i, j, id;
+	volatile int tot=0;
+	struct medida_martillos *m;
+
+	id=obtener_id_pr();
+
+	if ((desc=abrir_mutex("bm"))<0){
+		printf("martillo (%d): error abriendo bm\n", id);
+		return 0;
+	}
+	if ((m=abrir_memoria_compartida("bmt"))==0){
+		printf("martillo (%d): error abriendo bmt\n", id);
+		return 0;
+	}
+
+	for (i=0; i<TOT_ITER; i++){
+		if (lock(desc)<0)
+			printf("martillo (%d): error en lock. NO DEBE SALIR\n", id);
+
+		for (j=0; j<TRABAJO; j++)
+			tot+=j;
+
+		if (unlock(desc)<0)
+			printf("martillo (%d): error en unlock. NO DEBE SALIR\n", id);
+
+		for (j=0; j<TRABAJO; j++)
+			tot-=j;
+	}
+
+	/* terminados se incrementa despues de anotar el final: bench_mutex lo lee sin el mutex */
+	lock(desc);
+	if (m->terminados+1==m->esperados)
+		obtener_tiempo(&m->ticks_fin, &m->ns_fin);
+	m->terminados++;
+	unlock(desc);
+	cerrar_memoria_compartida(m);
+
+	printf("martillo (%d): termina tras %d secciones criticas\n", id, TOT_ITER);
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * usuario/perfil.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra un perfil plano de cada proceso vivo a
+ * partir de las muestras del contador de programa: porcentaje de muestras
+ * y numero de muestras por funcion, de mayor a menor. Las muestras tomadas
+ * dentro de una llamada al sistema aparecen con la imagen "kernel".
+ *
+ * Uso: un programa activa el muestreo con fijar_muestreo y lanza la carga;
+ * este programa se ejecuta antes de que termine, ya que las muestras se
+ * liberan con el proceso.
+ */
+
+#include "servicios.h"
+
+#define MAX_PROCESOS 16
+#define MAX_FUNCIONES 128
+#define TAM_NOMBRE 64
+
+struct funcion {
+	char nombre[TAM_NOMBRE];
+	int muestras;
+};
+
+struct instantanea inst;
+struct instantanea_proceso procesos[MAX_PROCESOS];
+void *pcs[NUM_MUESTRAS];
+struct funcion funciones[MAX_FUNCIONES];
+
+static int iguales(char *a, char *b){
+	while (*a && *a==*b){
+		a++;
+		b++;
+	}
+	return *a==*b;
+}
+
+static void copiar(char *destino, char *origen){
+	int i;
+
+	for (i=0; i<TAM_NOMBRE-1 && origen[i]; i++)
+		destino[i]=origen[i];
+	destino[i]='\0';
+}
+
+static int agrupar(int num){
+	int i, f, num_funciones=0;
+	char nombre[TAM_NOMBRE];
+
+	for (i=0; i<num; i++){
+		if (resolver_direccion(pcs[i], nombre, TAM_NOMBRE)<0)
+			copiar(nombre, "?? (desconocida)");
+		for (f=0; f<num_funciones && !iguales(funciones[f].nombre, nombre); f++);
+		if (f==num_funciones){
+			if (num_funciones==MAX_FUNCIONES)
+				continue;
+			copiar(funciones[f].nombre, nombre);
+			funciones[f].muestras=0;
+			num_funciones++;
+		}
+		funciones[f].muestras++;
+	}
+	return num_funciones;
+}
+
+static void ordenar(int num_funciones){
+	int i, j;
+	struct funcion aux;
+
+	for (i=1; i<num_funciones; i++)
+		for (j=i; j>0 && funciones[j].muestras>funciones[j-1].muestras; j--){
+			aux=funciones[j];
+			funciones[j]=funciones[j-1];
+			funciones[j-1]=aux;
+		}
+}
+
+int main(){
+	int i, f, num, perdidas, num_funciones, yo;
+
+	yo=obtener_id_pr();
+	if (obtener_instantanea(&inst, procesos, MAX_PROCESOS, 0, 0)<0){
+		printf("perfil: error obteniendo la instantanea\n");
+		return 1;
+	}
+
+	for (i=0; i<inst.num_procesos; i++){
+		if (procesos[i].id==yo)
+			continue;
+		num=leer_muestras(procesos[i].id, pcs, NUM_MUESTRAS, &perdidas);
+		if (num<=0)
+			continue;
+
+		num_funciones=agrupar(num);
+		ordenar(num_funciones);
+		printf("perfil del proceso %d: %d muestras (%d perdidas)\n",
+			procesos[i].id, num, perdidas);
+		printf("     %%  muestras  funcion\n");
+		for (f=0; f<num_funciones; f++)
+			printf("%4d.%d  %8d  %s\n", funciones[f].muestras*100/num,
+				funciones[f].muestras*1000/num%10,
+				funciones[f].muestras, funciones[f].nombre);
+	}
+	return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * usuario/prueba_ceder.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de ceder_cpu. Se pasa el
+ * turno con rebotador a traves de memoria compartida, primero cediendo el
+ * procesador mientras se espera y despues con espera activa, que consume
+ * la rodaja entera en cada turno.
+ */
+
+#include "servicios.h"
+
+#define RONDAS 20	/* turnos de cada fase */
+
+struct turnos {
+	int turno;	/* 0: prueba_ceder, 1: rebotador */
+	int ceder;	/* si se cede el procesador mientras se espera */
+};
+
+int main(){
+	struct turnos *t;
+	int i, inicio;
+
+	printf("prueba_ceder comienza\n");
+
+	if ((t=crear_memoria_compartida("turnos", sizeof(struct turnos)))==0)
+		printf("error creando turnos. NO DEBE APARECER\n");
+	t->ceder=1;
+
+	if (crear_proceso("rebotador")<0)
+		printf("Error creando rebotador\n");
+
+	inicio=obtener_ticks();
+	for (i=0; i<RONDAS; i++){
+		while (t->turno!=0)
+			ceder_cpu();
+		t->turno=1;
+	}
+	printf("prueba_ceder: %d turnos cediendo en %d ticks\n", RONDAS,
+		obtener_ticks()-inicio);
+
+	while (t->turno!=0)
+		ceder_cpu();
+	t->ceder=0;
+
+	inicio=obtener_ticks();
+	for (i=0; i<RONDAS; i++){
+		while (t->turno!=0)
+			;
+		t->turno=1;
+	}
+	printf("prueba_ceder: %d turnos con espera activa en %d ticks\n", RONDAS,
+		obtener_ticks()-inicio);
+
+	printf("prueba_ceder termina\n");
+	return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * usuario/prueba_colas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las colas de mensajes.
+ * Envia mensajes grandes a consumidor a traves de una cola de capacidad
+ * reducida, por lo que debe bloquearse cuando la cola se llena.
+ */
+
+#include "servicios.h"
+
+#define CAPACIDAD 4		/* mensajes que caben en la cola */
+#define NUM_MENSAJES 10	/* mensajes enviados a consumidor */
+#define TAM_MENSAJE 8192	/* bytes de cada mensaje */
+
+int main(){
+	int cola, i, j;
+	char *buffer;
+	void *recibido;
+
+	printf("prueba_colas comienza\n");
+
+	if ((cola=crear_cola("cq", CAPACIDAD))<0)
+		printf("error creando cq. NO DEBE APARECER\n");
+
+	if (crear_cola("cq", CAPACIDAD)!=cola)
+		printf("error abriendo cq existente. NO DEBE APARECER\n");
+
+	if (recibir(cola, &recibido, NO_BLOQUEANTE)==COLA_VACIA)
+		printf("recibir no bloqueante sobre cola vacia. DEBE APARECER\n");
+
+	if (crear_proceso("consumidor")<0)
+		printf("Error creando consumidor\n");
+
+	for (i=0; i<NUM_MENSAJES; i++){
+		if ((buffer=reservar_buffer(TAM_MENSAJE))==0){
+			printf("error reservando buffer. NO DEBE APARECER\n");
+			break;
+		}
+		for (j=0; j<TAM_MENSAJE; j++)
+			buffer[j]=(char)(i+j);
+
+		/* se bloquea cuando hay CAPACIDAD mensajes sin recibir */
+		if (enviar(cola, buffer, TAM_MENSAJE, BLOQUEANTE)<0)
+			printf("error enviando mensaje. NO DEBE APARECER\n");
+		printf("prueba_colas ha enviado el mensaje %d\n", i);
+	}
+
+	printf("prueba_colas termina\n");
+	return 0;
+}
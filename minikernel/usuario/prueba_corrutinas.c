@@ -0,0 +1,90 @@
+/*
+ * usuario/prueba_corrutinas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la biblioteca de
+ * corrutinas. Un testigo da varias vueltas a un anillo de corrutinas
+ * unidas por canales mientras otra duerme por plazos y otra lee del
+ * terminal los caracteres que se escriban. Un hilo del proceso no puede
+ * crear corrutinas mientras main las ejecuta.
+ */
+
+#include "servicios.h"
+#include "corrutinas.h"
+
+#define NUM_ANILLO 1000	/* corrutinas del anillo */
+#define VUELTAS 3		/* vueltas que da el testigo */
+#define NUM_CARACTERES 5	/* caracteres que lee el lector */
+
+canal *canales[NUM_ANILLO];
+int saltos=0;
+
+void eslabon(void *arg){
+	long i=(long)arg;
+	long testigo;
+
+	do {
+		testigo=(long)co_recibir(canales[i]);
+		saltos++;
+		/* la ultima vuelta se propaga con 0 para terminar el anillo */
+		if (i==NUM_ANILLO-1 && testigo>0)
+			testigo--;
+		co_enviar(canales[(i+1)%NUM_ANILLO], (void *)testigo);
+	} while (testigo>0);
+}
+
+void dormilona(void *arg){
+	int i, antes;
+
+	for (i=0; i<3; i++){
+		antes=obtener_ticks();
+		co_dormir(50);
+		printf("dormilona: ha dormido %d ticks\n", obtener_ticks()-antes);
+	}
+}
+
+void lector(void *arg){
+	int i;
+
+	for (i=0; i<NUM_CARACTERES; i++)
+		printf("lector: caracter %c\n", co_leer_caracter());
+}
+
+/* hilo del proceso: las corrutinas las esta usando main */
+void intruso(void *arg){
+	if (co_crear(lector, 0)<0)
+		printf("intruso no puede crear corrutinas. DEBE APARECER\n");
+}
+
+int main(){
+	long i;
+
+	printf("prueba_corrutinas comienza\n");
+
+	for (i=0; i<NUM_ANILLO; i++)
+		if ((canales[i]=co_crear_canal(1))==0)
+			printf("error creando canal. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_ANILLO; i++)
+		if (co_crear(eslabon, (void *)i)<0)
+			printf("error creando corrutina. NO DEBE APARECER\n");
+
+	co_crear(dormilona, 0);
+	co_crear(lector, 0);
+
+	co_enviar(canales[0], (void *)(long)VUELTAS);
+	crear_hilo(intruso, 0);
+
+	if (co_ejecutar()<0)
+		printf("corrutinas interbloqueadas. NO DEBE APARECER\n");
+
+	/* la ultima corrutina del anillo termina sin volver a recibir */
+	printf("prueba_corrutinas: %d saltos (esperados %d)\n", saltos,
+		NUM_ANILLO*(VUELTAS+1)-1);
+	printf("prueba_corrutinas termina\n");
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * usuario/prueba_cuotas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de los grupos con cuota de
+ * procesador. Dos hilos que consumen todo el procesador compiten durante
+ * el mismo tiempo: el del grupo limitado al 20% de cada ventana debe
+ * avanzar mucho menos que el del grupo sin limite.
+ */
+
+#include "servicios.h"
+
+#define LIMITADO 1
+#define LIBRE 2
+#define DURACION 500	/* ticks que compiten los hilos */
+
+int fin;
+int vueltas[3];
+int terminados=0;
+
+void consumir(void *arg){
+	long grupo=(long)arg;
+
+	fijar_grupo(grupo);
+	while (obtener_ticks()<fin)
+		vueltas[grupo]++;
+	terminados++;
+}
+
+int main(){
+	printf("prueba_cuotas comienza\n");
+
+	if (fijar_cuota(LIMITADO, 20)<0)
+		printf("error fijando cuota. NO DEBE APARECER\n");
+	if (fijar_cuota(LIBRE, 1000)==0)
+		printf("cuota mayor que la ventana. NO DEBE APARECER\n");
+
+	fin=obtener_ticks()+DURACION;
+	crear_hilo(consumir, (void *)LIMITADO);
+	crear_hilo(consumir, (void *)LIBRE);
+
+	while (terminados<2)
+		dormir_ticks(10);
+
+	printf("prueba_cuotas: limitado %d vueltas, libre %d vueltas\n",
+		vueltas[LIMITADO], vueltas[LIBRE]);
+	if (vueltas[LIMITADO]*2>vueltas[LIBRE])
+		printf("el grupo limitado no respeta su cuota. NO DEBE APARECER\n");
+
+	printf("prueba_cuotas termina\n");
+	return 0;
+}
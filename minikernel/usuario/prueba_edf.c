@@ -0,0 +1,86 @@
+/*
+ * usuario/prueba_edf.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la planificacion de tiempo
+ * real. Dos hilos periodicos cumplen sus plazos aunque un hilo normal
+ * consume todo el procesador que le dejan. Una tercera tarea que haria
+ * superar la utilizacion maxima se rechaza y otra que trabaja mas que su
+ * presupuesto pierde sus plazos.
+ */
+
+#include "servicios.h"
+
+#define ACTIVACIONES 10
+
+struct tarea {
+	char *nombre;
+	int periodo;
+	int presupuesto;
+	int trabajo;	/* ticks de trabajo en cada periodo */
+	int activaciones;
+};
+
+struct tarea tareas[]={
+	{ "rapida", 20, 6, 3, ACTIVACIONES },
+	{ "lenta", 50, 20, 10, ACTIVACIONES/2 },
+	{ "excesiva", 100, 5, 10, 2 },
+};
+
+int terminadas=0;
+
+void trabajar(int ticks){
+	int inicio=obtener_ticks();
+
+	while (obtener_ticks()-inicio<ticks)
+		;
+}
+
+void periodica(void *arg){
+	struct tarea *t=arg;
+	int i;
+
+	if (fijar_tiempo_real(t->periodo, t->presupuesto)<0){
+		printf("%s: rechazada. NO DEBE APARECER\n", t->nombre);
+		return;
+	}
+	for (i=0; i<t->activaciones; i++){
+		trabajar(t->trabajo);
+		esperar_periodo();
+	}
+	printf("%s: %d activaciones, %d plazos perdidos\n", t->nombre,
+		t->activaciones, plazos_perdidos());
+	terminadas++;
+}
+
+void acaparador(void *arg){
+	/* solo se ejecuta en el tiempo que dejan las tareas de tiempo real */
+	while (terminadas<3)
+		;
+	printf("acaparador termina\n");
+}
+
+int main(){
+	printf("prueba_edf comienza\n");
+
+	crear_hilo(acaparador, 0);
+	crear_hilo(periodica, &tareas[0]);
+	crear_hilo(periodica, &tareas[1]);
+
+	/* cuando las tareas se han declarado, 300 + 400 + 600 milesimas
+	   supera el maximo */
+	dormir_ticks(5);
+	if (fijar_tiempo_real(10, 6)==SOBRECARGA)
+		printf("prueba_edf: tarea rechazada por sobrecarga. DEBE APARECER\n");
+	else
+		printf("prueba_edf: tarea admitida. NO DEBE APARECER\n");
+
+	crear_hilo(periodica, &tareas[2]);
+
+	printf("prueba_edf termina\n");
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * usuario/prueba_estadisticas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las estadisticas por
+ * proceso. Un hilo calcula mientras otro duerme y espera por un mutex que
+ * retiene el primero; despues se muestra en que ha gastado el tiempo cada uno.
+ */
+
+#include "servicios.h"
+
+#define TRABAJO 300000000
+
+int mut;
+int fase=0;
+
+void mostrar(int id){
+	struct estadisticas e;
+
+	if (obtener_estadisticas(id, &e)<0){
+		printf("error obteniendo estadisticas de %d. NO DEBE APARECER\n", id);
+		return;
+	}
+	printf("proceso %d: ejecucion %d listo %d dormido %d mutex %d terminal %d aparcado %d otros %d\n",
+		e.id, e.ticks_ejecucion, e.ticks_listo, e.ticks_dormido,
+		e.ticks_bloqueado_mutex, e.ticks_bloqueado_terminal,
+		e.ticks_aparcado, e.ticks_bloqueado_otros);
+	printf("proceso %d: %d cambios voluntarios, %d involuntarios, %d llamadas\n",
+		e.id, e.cambios_voluntarios, e.cambios_involuntarios,
+		e.llamadas_sistema);
+}
+
+void esperar(void *arg){
+	dormir_ticks(2);
+	lock(mut);	/* lo tiene main mientras calcula */
+	unlock(mut);
+	fase=1;
+	dormir_ticks(100);	/* sigue existiendo mientras main lo consulta */
+}
+
+int main(){
+	volatile int i;
+	int hilo;
+
+	printf("prueba_estadisticas comienza\n");
+
+	if ((mut=crear_mutex("mest", NO_RECURSIVO))<0)
+		printf("error creando mest. NO DEBE APARECER\n");
+
+	lock(mut);
+	hilo=crear_hilo(esperar, 0);
+	for (i=0; i<TRABAJO; i++);
+	unlock(mut);
+
+	while (!fase)
+		dormir_ticks(5);
+
+	mostrar(-1);
+	mostrar(hilo);
+
+	if (obtener_estadisticas(99, 0)!=-1)
+		printf("estadisticas de un proceso inexistente. NO DEBE APARECER\n");
+
+	printf("prueba_estadisticas termina\n");
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * usuario/prueba_hilos.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de los hilos. Varios hilos
+ * incrementan una variable global protegida por un mutex abierto antes de
+ * crearlos. El proceso termina antes que su ultimo hilo, que debe seguir
+ * ejecutandose sobre la imagen del proceso. Tampoco se puede cerrar el
+ * mutex mientras otro hilo lo posee.
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 3
+#define NUM_SUMAS 1000	/* incrementos realizados por cada hilo */
+
+int mut;
+int contador=0;
+
+void sumar(void *arg){
+	int i;
+
+	printf("hilo %d (%s) comienza\n", obtener_id_pr(), (char *)arg);
+	for (i=0; i<NUM_SUMAS; i++){
+		lock(mut);
+		contador++;
+		unlock(mut);
+	}
+	printf("hilo %d (%s) termina\n", obtener_id_pr(), (char *)arg);
+}
+
+void abandonar(void *arg){
+	/* termina sin hacer unlock: el mutex debe quedar libre */
+	lock(mut);
+	printf("hilo abandona el mutex\n");
+}
+
+void retener(void *arg){
+	/* posee el mutex mientras el proceso intenta cerrarlo */
+	lock(mut);
+	dormir(1);
+	unlock(mut);
+}
+
+void tardio(void *arg){
+	dormir(1);
+	printf("hilo tardio: contador %d tras terminar el proceso\n", contador);
+}
+
+int main(){
+	int i;
+
+	printf("prueba_hilos comienza\n");
+
+	if ((mut=crear_mutex("mh", NO_RECURSIVO))<0)
+		printf("error creando mh. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_HILOS; i++)
+		if (crear_hilo(sumar, "sumar")<0)
+			printf("error creando hilo. NO DEBE APARECER\n");
+
+	dormir(1);
+	printf("prueba_hilos: contador %d (esperado %d)\n", contador,
+		NUM_HILOS*NUM_SUMAS);
+
+	crear_hilo(retener, 0);
+	dormir_ticks(10);
+	if (cerrar_mutex(mut)==0)
+		printf("cerrado el mutex que posee otro hilo. NO DEBE APARECER\n");
+	dormir(1);
+
+	crear_hilo(abandonar, 0);
+	dormir(1);
+	if (trylock(mut)<0)
+		printf("mutex abandonado sigue ocupado. NO DEBE APARECER\n");
+	unlock(mut);
+
+	crear_hilo(tardio, 0);
+	printf("prueba_hilos termina\n");
+	return 0;
+}
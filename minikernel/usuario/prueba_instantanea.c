@@ -0,0 +1,76 @@
+/*
+ * usuario/prueba_instantanea.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de obtener_instantanea. Deja
+ * un proceso dormido y un hilo bloqueado en un mutex que retiene main, y
+ * comprueba que la instantanea los muestra en sus colas. Despues lanza ps.
+ */
+
+#include "servicios.h"
+
+struct instantanea inst;
+struct instantanea_proceso procesos[16];
+struct instantanea_mutex mutex[16];
+
+int mut;
+
+void esperar(void *arg){
+	lock(mut);	/* lo tiene main */
+	unlock(mut);
+}
+
+struct instantanea_proceso *buscar(int id){
+	int i;
+
+	for (i=0; i<inst.num_procesos; i++)
+		if (procesos[i].id==id)
+			return &procesos[i];
+	return 0;
+}
+
+int main(){
+	int yo, hilo, i;
+	struct instantanea_proceso *p;
+
+	printf("prueba_instantanea comienza\n");
+	yo=obtener_id_pr();
+
+	if ((mut=crear_mutex("minst", NO_RECURSIVO))<0)
+		printf("error creando minst. NO DEBE APARECER\n");
+	lock(mut);
+	hilo=crear_hilo(esperar, 0);
+	crear_proceso("dormilon");
+	dormir_ticks(5);	/* el hilo se bloquea y dormilon se duerme */
+
+	if (obtener_instantanea(&inst, procesos, 16, mutex, 16)<0)
+		printf("error obteniendo la instantanea. NO DEBE APARECER\n");
+
+	if (inst.proceso_actual!=yo || (p=buscar(yo))==0 || p->cola!=COLA_LISTOS)
+		printf("main no aparece en ejecucion. NO DEBE APARECER\n");
+	if ((p=buscar(hilo))==0 || p->cola!=COLA_MUTEX_LOCK || p->lider!=yo)
+		printf("el hilo no aparece bloqueado en lock. NO DEBE APARECER\n");
+	else if (p->mutex_esperado<0 || mutex[0].id!=p->mutex_esperado)
+		printf("el hilo no espera por minst. NO DEBE APARECER\n");
+	if (inst.longitud_colas[COLA_DORMIR]!=1 || inst.longitud_colas[COLA_MUTEX_LOCK]!=1)
+		printf("longitud de colas incorrecta. NO DEBE APARECER\n");
+	for (i=0; i<inst.num_procesos; i++)
+		if (procesos[i].cola==COLA_DORMIR && procesos[i].ticks_restantes<=0)
+			printf("dormido sin ticks restantes. NO DEBE APARECER\n");
+	if (inst.num_mutex!=1 || mutex[0].propietario!=yo || mutex[0].bloqueados!=1)
+		printf("estado de minst incorrecto. NO DEBE APARECER\n");
+
+	if (obtener_instantanea(&inst, procesos, 1, mutex, 0)<0 || inst.num_procesos!=1 || inst.num_mutex!=0)
+		printf("no se respeta el tamano de los buffers. NO DEBE APARECER\n");
+
+	crear_proceso("ps");
+	dormir_ticks(5);
+	unlock(mut);
+
+	printf("prueba_instantanea termina\n");
+	return 0;
+}
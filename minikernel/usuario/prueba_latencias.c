@@ -0,0 +1,99 @@
+/*
+ * usuario/prueba_latencias.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las latencias de
+ * planificacion. Crea hilos que duermen, que esperan un mutex que main
+ * cede y que calculan hasta agotar la rodaja, y muestra la latencia media
+ * y maxima de cada motivo y la cola de listos de los ultimos ticks.
+ */
+
+#include "servicios.h"
+
+#define TRABAJO 100000000
+
+static char *nombre_causa[]={ "nuevo", "dormir", "terminal", "mutex",
+	"plazo", "tiempo_real", "cuota", "expulsion", "otra" };
+
+struct latencias lat;
+int mut;
+int terminados=0;
+
+void dormilon(void *arg){
+	int i;
+
+	for (i=0; i<5; i++)
+		dormir_ticks(1);
+	terminados++;
+}
+
+void esperar_mutex(void *arg){
+	lock(mut);	/* lo tiene main */
+	unlock(mut);
+	terminados++;
+}
+
+void calcular(void *arg){
+	volatile int i;
+
+	for (i=0; i<TRABAJO; i++);
+	terminados++;
+}
+
+int suma(int *v, int n){
+	int i, total=0;
+
+	for (i=0; i<n; i++)
+		total+=v[i];
+	return total;
+}
+
+int main(){
+	int c, t, tick;
+
+	printf("prueba_latencias comienza\n");
+
+	if ((mut=crear_mutex("mlat", NO_RECURSIVO))<0)
+		printf("error creando mlat. NO DEBE APARECER\n");
+	lock(mut);
+
+	obtener_latencias(0, 1);
+	crear_hilo(dormilon, 0);
+	crear_hilo(esperar_mutex, 0);
+	crear_hilo(calcular, 0);
+	crear_hilo(calcular, 0);
+	dormir_ticks(3);
+	unlock(mut);
+	while (terminados<4)
+		dormir_ticks(5);
+
+	tick=obtener_latencias(&lat, 0);
+	printf("motivo       despachos  media(ciclos)  maxima(ciclos)\n");
+	for (c=0; c<NUM_CAUSAS_LISTO; c++){
+		if (lat.despachos[c]==0)
+			continue;
+		printf("%-12s %9d %14llu %15llu\n", nombre_causa[c], lat.despachos[c],
+			lat.latencia_total[c]/lat.despachos[c], lat.latencia_max[c]);
+		if (suma(lat.histograma[c], NUM_CUBETAS_HISTOGRAMA)!=lat.despachos[c])
+			printf("histograma de %s incorrecto. NO DEBE APARECER\n", nombre_causa[c]);
+	}
+	if (lat.despachos[CAUSA_NUEVO]!=4 || lat.despachos[CAUSA_DORMIR]<5 ||
+	    lat.despachos[CAUSA_MUTEX]!=1 || lat.despachos[CAUSA_EXPULSION]==0)
+		printf("faltan despachos. NO DEBE APARECER\n");
+
+	printf("procesos esperando en los ultimos 20 ticks:");
+	for (t=tick-19; t<=tick; t++)
+		printf(" %d", lat.historial_listos[t%TAM_HISTORIAL_LISTOS]);
+	printf("\n");
+	if (suma(lat.ticks_con_longitud, MAX_PROC+1)!=lat.ticks || lat.ticks==0)
+		printf("ticks por longitud incorrectos. NO DEBE APARECER\n");
+	if (suma(lat.ticks_con_longitud+1, MAX_PROC)==0)
+		printf("la cola de listos nunca ha tenido procesos esperando. NO DEBE APARECER\n");
+
+	printf("prueba_latencias termina\n");
+	return 0;
+}
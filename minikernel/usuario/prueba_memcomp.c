@@ -0,0 +1,66 @@
+/*
+ * usuario/prueba_memcomp.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la memoria compartida.
+ * Crea un segmento que incrementan dos procesos sumador protegidos por un
+ * mutex y comprueba el resultado cuando ambos han terminado.
+ */
+
+#include "servicios.h"
+
+#define NUM_SUMADORES 2
+#define NUM_SUMAS 1000	/* incrementos realizados por cada sumador */
+
+int main(){
+	int *contador, *otro, i;
+
+	printf("prueba_memcomp comienza\n");
+
+	if ((contador=crear_memoria_compartida("shm", 10000))==0)
+		printf("error creando shm. NO DEBE APARECER\n");
+
+	if (crear_memoria_compartida("shm", 100)==0)
+		printf("error creando shm duplicado. DEBE APARECER\n");
+
+	if (crear_memoria_compartida("enorme", 2000000)==0)
+		printf("error creando segmento demasiado grande. DEBE APARECER\n");
+
+	if (abrir_memoria_compartida("nada")==0)
+		printf("error abriendo segmento inexistente. DEBE APARECER\n");
+
+	if (*contador!=0)
+		printf("segmento no inicializado a 0. NO DEBE APARECER\n");
+
+	if (crear_mutex("msum", NO_RECURSIVO)<0)
+		printf("error creando msum. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_SUMADORES; i++)
+		if (crear_proceso("sumador")<0)
+			printf("Error creando sumador\n");
+
+	/* los sumadores ven el mismo segmento */
+	dormir(2);
+	printf("prueba_memcomp: contador %d (esperado %d)\n", *contador,
+		NUM_SUMADORES*NUM_SUMAS);
+
+	/* abrir de nuevo devuelve la misma direccion */
+	if ((otro=abrir_memoria_compartida("shm"))!=contador)
+		printf("direccion distinta al reabrir. NO DEBE APARECER\n");
+	if (cerrar_memoria_compartida(otro)<0)
+		printf("error cerrando shm. NO DEBE APARECER\n");
+
+	if (cerrar_memoria_compartida(contador)<0)
+		printf("error cerrando shm. NO DEBE APARECER\n");
+
+	/* con la ultima referencia cerrada el nombre queda libre */
+	if (abrir_memoria_compartida("shm")==0)
+		printf("shm ya no existe. DEBE APARECER\n");
+
+	printf("prueba_memcomp termina\n");
+	return 0;
+}
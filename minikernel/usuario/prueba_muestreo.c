@@ -0,0 +1,81 @@
+/*
+ * usuario/prueba_muestreo.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba del muestreo del contador de
+ * programa. Calcula en dos funciones, una con el triple de trabajo que la
+ * otra, y comprueba que las muestras guardan esa proporcion. Despues lanza
+ * perfil para mostrar su perfil plano.
+ */
+
+#include "servicios.h"
+
+#define TRABAJO 100000000
+
+void *pcs[NUM_MUESTRAS];
+
+/* no son static para que sus simbolos sean visibles en la imagen */
+void calculo_largo(){
+	volatile int i;
+
+	for (i=0; i<3*TRABAJO; i++);
+}
+
+void calculo_corto(){
+	volatile int i;
+
+	for (i=0; i<TRABAJO; i++);
+}
+
+int empieza(char *nombre, char *prefijo){
+	while (*prefijo && *nombre==*prefijo){
+		nombre++;
+		prefijo++;
+	}
+	return *prefijo=='\0';
+}
+
+int main(){
+	int i, num, perdidas, largo=0, corto=0;
+	char nombre[64];
+
+	printf("prueba_muestreo comienza\n");
+
+	if (fijar_muestreo(1)!=0)
+		printf("el muestreo estaba activo. NO DEBE APARECER\n");
+	calculo_largo();
+	calculo_corto();
+	calculo_largo();
+	calculo_corto();
+
+	num=leer_muestras(-1, pcs, NUM_MUESTRAS, &perdidas);
+	if (num<=0){
+		printf("no hay muestras. NO DEBE APARECER\n");
+		return 1;
+	}
+	for (i=0; i<num; i++){
+		if (resolver_direccion(pcs[i], nombre, sizeof(nombre))<0)
+			continue;
+		if (empieza(nombre, "calculo_largo (prueba_muestreo)"))
+			largo++;
+		else if (empieza(nombre, "calculo_corto (prueba_muestreo)"))
+			corto++;
+	}
+	printf("%d muestras: %d en calculo_largo y %d en calculo_corto\n", num, largo, corto);
+	if (corto==0 || largo<2*corto)
+		printf("proporcion de muestras incorrecta. NO DEBE APARECER\n");
+
+	crear_proceso("perfil");
+	dormir_ticks(10);
+	fijar_muestreo(0);
+
+	if (leer_muestras(99, pcs, NUM_MUESTRAS, 0)!=-1)
+		printf("muestras de un proceso inexistente. NO DEBE APARECER\n");
+
+	printf("prueba_muestreo termina\n");
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * usuario/prueba_pagina_tiempo.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la pagina de tiempo.
+ * Comprueba que leer_ticks y leer_ns coinciden con obtener_tiempo, compara
+ * su coste con el de la llamada al sistema y termina intentando escribir
+ * en la pagina, lo que debe provocar una excepcion de memoria.
+ */
+
+#include "servicios.h"
+
+#define ITER 200000
+
+int main(){
+	const struct pagina_tiempo *pag;
+	unsigned long long ns, antes, despues, t_llamada, t_pagina;
+	int i, ticks, errores=0;
+	volatile int total=0;
+
+	printf("prueba_pagina_tiempo comienza\n");
+
+	if ((pag=obtener_pagina_tiempo())==0){
+		printf("error obteniendo la pagina de tiempo. NO DEBE APARECER\n");
+		return 1;
+	}
+
+	/* el tick puede cambiar entre las dos lecturas */
+	for (i=0; i<20; i++){
+		obtener_tiempo(&ticks, &ns);
+		if (leer_ticks()-ticks>1 || leer_ticks()<ticks)
+			errores++;
+		antes=leer_ns();
+		obtener_tiempo(0, &ns);
+		despues=leer_ns();
+		if (ns<antes || ns>despues)
+			errores++;
+		dormir_ticks(1);
+	}
+	printf("prueba_pagina_tiempo: %d lecturas no coinciden con obtener_tiempo\n", errores);
+
+	antes=leer_ns();
+	for (i=0; i<ITER; i++)
+		total+=obtener_ticks();
+	t_llamada=leer_ns()-antes;
+
+	antes=leer_ns();
+	for (i=0; i<ITER; i++)
+		total+=leer_ticks();
+	t_pagina=leer_ns()-antes;
+
+	printf("prueba_pagina_tiempo: obtener_ticks %llu ns, leer_ticks %llu ns (%s)\n",
+		t_llamada/ITER, t_pagina/ITER,
+		(t_pagina<t_llamada) ? "la pagina es mas rapida" : "LA PAGINA NO ES MAS RAPIDA");
+
+	printf("prueba_pagina_tiempo: escribe en la pagina. DEBE PRODUCIRSE UNA EXCEPCION\n");
+	*(int *)&pag->ticks=0;
+
+	printf("prueba_pagina_tiempo: se ha escrito en la pagina. NO DEBE APARECER\n");
+	return 0;
+}
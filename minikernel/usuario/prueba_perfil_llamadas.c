@@ -0,0 +1,72 @@
+/*
+ * usuario/prueba_perfil_llamadas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba del perfil de llamadas al
+ * sistema. Hace varias llamadas rapidas y una que se bloquea y comprueba
+ * los contadores del proceso y del sistema.
+ */
+
+#include "servicios.h"
+
+/* numeros de servicio de minikernel/include/llamsis.h */
+#define OBTENER_ID 3
+#define DORMIR_TICKS 28
+
+#define LLAMADAS 50
+
+int suma(int *histograma){
+	int c, total=0;
+
+	for (c=0; c<NUM_CUBETAS_HISTOGRAMA; c++)
+		total+=histograma[c];
+	return total;
+}
+
+void mostrar(char *nombre, struct perfil_llamada *p){
+	printf("%s: %d llamadas, media %llu ciclos, minimo %llu, maximo %llu\n",
+		nombre, p->llamadas, p->llamadas ? p->ciclos_total/p->llamadas : 0,
+		p->ciclos_min, p->ciclos_max);
+}
+
+int main(){
+	int i;
+	struct perfil_llamada id, dormir, sistema;
+
+	printf("prueba_perfil_llamadas comienza\n");
+
+	for (i=0; i<LLAMADAS; i++)
+		obtener_id_pr();
+	dormir_ticks(2);
+
+	if (obtener_perfil_llamada(OBTENER_ID, -1, &id)<0 ||
+	    obtener_perfil_llamada(DORMIR_TICKS, obtener_id_pr(), &dormir)<0 ||
+	    obtener_perfil_llamada(OBTENER_ID, PERFIL_SISTEMA, &sistema)<0){
+		printf("error obteniendo el perfil. NO DEBE APARECER\n");
+		return 1;
+	}
+	mostrar("obtener_id_pr", &id);
+	mostrar("dormir_ticks", &dormir);
+	mostrar("obtener_id_pr (sistema)", &sistema);
+
+	if (id.llamadas!=LLAMADAS || dormir.llamadas!=1)
+		printf("numero de llamadas incorrecto. NO DEBE APARECER\n");
+	if (id.ciclos_min>id.ciclos_max || id.ciclos_total<id.ciclos_max ||
+	    suma(id.histograma)!=id.llamadas)
+		printf("tiempos de obtener_id_pr incoherentes. NO DEBE APARECER\n");
+	if (dormir.ciclos_min<=id.ciclos_max)
+		printf("dormir no incluye el tiempo bloqueado. NO DEBE APARECER\n");
+	/* la llamada que pide el perfil del proceso por id es una mas */
+	if (sistema.llamadas<LLAMADAS+1)
+		printf("el perfil del sistema no incluye al proceso. NO DEBE APARECER\n");
+
+	if (obtener_perfil_llamada(99, -1, &id)!=-1 || obtener_perfil_llamada(OBTENER_ID, 99, &id)!=-1)
+		printf("perfil de un servicio o proceso inexistente. NO DEBE APARECER\n");
+
+	printf("prueba_perfil_llamadas termina\n");
+	return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * usuario/prueba_perfil_mutex.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba del perfil de contencion de
+ * mutex. Varios hilos compiten por un mutex que retienen mientras calculan
+ * y otro mutex solo lo usa main; despues se muestran ambos perfiles. Al
+ * terminar el sistema se vuelca el perfil de todos los mutex.
+ */
+
+#include "servicios.h"
+
+#define HILOS 3
+#define VUELTAS 4
+#define TRABAJO 50000000
+
+int disputado, tranquilo;
+int terminados=0;
+
+void competir(void *arg){
+	volatile int i;
+	int v;
+
+	for (v=0; v<VUELTAS; v++){
+		lock(disputado);
+		for (i=0; i<TRABAJO; i++);
+		unlock(disputado);
+	}
+	terminados++;
+}
+
+int iguales(char *a, char *b){
+	while (*a && *a==*b){
+		a++;
+		b++;
+	}
+	return *a==*b;
+}
+
+int id_mutex(char *nombre){
+	struct instantanea inst;
+	struct instantanea_mutex mutex[16];
+	int i;
+
+	obtener_instantanea(&inst, 0, 0, mutex, 16);
+	for (i=0; i<inst.num_mutex; i++)
+		if (iguales(mutex[i].nombre, nombre))
+			return mutex[i].id;
+	return -1;
+}
+
+void mostrar(struct perfil_mutex *p){
+	int c;
+
+	printf("%s: %d adquisiciones, %d disputadas, %d liberaciones, maximo %d bloqueados\n",
+		p->nombre, p->adquisiciones, p->adquisiciones_disputadas,
+		p->liberaciones, p->max_bloqueados);
+	for (c=0; c<NUM_CUBETAS_HISTOGRAMA; c++)
+		if (p->histograma_espera[c] || p->histograma_retencion[c])
+			printf("  2^%d ciclos: %d esperas %d retenciones\n", c,
+				p->histograma_espera[c], p->histograma_retencion[c]);
+}
+
+int suma(int *histograma){
+	int c, total=0;
+
+	for (c=0; c<NUM_CUBETAS_HISTOGRAMA; c++)
+		total+=histograma[c];
+	return total;
+}
+
+int main(){
+	int i;
+	struct perfil_mutex p;
+
+	printf("prueba_perfil_mutex comienza\n");
+
+	if ((disputado=crear_mutex("disput", NO_RECURSIVO))<0 ||
+	    (tranquilo=crear_mutex("tranq", RECURSIVO))<0)
+		printf("error creando mutex. NO DEBE APARECER\n");
+
+	for (i=0; i<HILOS; i++)
+		crear_hilo(competir, 0);
+	for (i=0; i<VUELTAS; i++){
+		lock(tranquilo);
+		lock(tranquilo);	/* lock recursivo: no es otra adquisicion */
+		unlock(tranquilo);
+		unlock(tranquilo);
+	}
+	while (terminados<HILOS)
+		dormir_ticks(5);
+
+	if (obtener_perfil_mutex(id_mutex("disput"), &p)<0)
+		printf("error obteniendo el perfil. NO DEBE APARECER\n");
+	mostrar(&p);
+	if (p.adquisiciones!=HILOS*VUELTAS || p.liberaciones!=HILOS*VUELTAS)
+		printf("numero de adquisiciones incorrecto. NO DEBE APARECER\n");
+	if (p.adquisiciones_disputadas==0 || p.max_bloqueados==0 || p.espera_max==0)
+		printf("no se ha registrado contencion. NO DEBE APARECER\n");
+	if (suma(p.histograma_espera)!=p.adquisiciones_disputadas ||
+	    suma(p.histograma_retencion)!=p.liberaciones)
+		printf("histogramas incorrectos. NO DEBE APARECER\n");
+
+	if (obtener_perfil_mutex(id_mutex("tranq"), &p)<0)
+		printf("error obteniendo el perfil. NO DEBE APARECER\n");
+	mostrar(&p);
+	if (p.adquisiciones!=VUELTAS || p.adquisiciones_disputadas!=0)
+		printf("perfil del mutex sin contencion incorrecto. NO DEBE APARECER\n");
+
+	if (obtener_perfil_mutex(-1, &p)!=-1)
+		printf("perfil de un mutex inexistente. NO DEBE APARECER\n");
+
+	printf("prueba_perfil_mutex termina\n");
+	return 0;
+}
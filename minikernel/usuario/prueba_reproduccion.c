@@ -0,0 +1,63 @@
+/*
+ * usuario/prueba_reproduccion.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que comprueba la grabacion y reproduccion de eventos
+ * externos. Varios hilos alternan calculo y llamadas a obtener_tiempo y
+ * resumen en una firma el tick que ve cada llamada, que depende de como
+ * se reparten los ticks y las expulsiones entre los hilos. Se ejecuta una
+ * vez con MINIKERNEL_GRABAR=fichero y otra con MINIKERNEL_REPRODUCIR=fichero:
+ * las firmas de las dos ejecuciones deben coincidir, aunque varien de una
+ * ejecucion normal a otra.
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 3
+#define NUM_LLAMADAS 20000	/* llamadas a obtener_tiempo de cada hilo */
+#define TRABAJO 2000		/* iteraciones de calculo entre llamadas */
+
+unsigned int firma[NUM_HILOS];
+int terminados=0;
+
+/* FNV-1a de los ticks observados. El estado va en variables locales */
+void trabajar(void *arg){
+	int n=(long)arg;
+	unsigned int h=2166136261U;
+	int i, ticks;
+	volatile int j;
+
+	for (i=0; i<NUM_LLAMADAS; i++){
+		obtener_tiempo(&ticks, 0);
+		h=(h^(unsigned int)ticks)*16777619U;
+		for (j=0; j<TRABAJO; j++);
+	}
+	firma[n]=h;
+	__sync_fetch_and_add(&terminados, 1);
+}
+
+int main(){
+	unsigned int total=0;
+	long i;
+
+	printf("prueba_reproduccion comienza\n");
+
+	for (i=0; i<NUM_HILOS; i++)
+		if (crear_hilo(trabajar, (void *)i)<0)
+			printf("error creando hilo. NO DEBE APARECER\n");
+
+	while (terminados<NUM_HILOS)
+		dormir_ticks(10);
+
+	for (i=0; i<NUM_HILOS; i++){
+		printf("REPRODUCCION hilo=%ld firma=%08x\n", i, firma[i]);
+		total=(total^firma[i])*16777619U;
+	}
+	printf("REPRODUCCION total=%08x\n", total);
+	printf("prueba_reproduccion termina\n");
+	return 0;
+}
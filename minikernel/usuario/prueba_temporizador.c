@@ -0,0 +1,69 @@
+/*
+ * usuario/prueba_temporizador.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de dormir por ticks y de los
+ * temporizadores periodicos. En cada periodo se hace un trabajo de
+ * duracion variable: con dormir_ticks el retraso se acumula y con el
+ * temporizador los despertares siguen en multiplos exactos del periodo.
+ */
+
+#include "servicios.h"
+
+#define PERIODO 10	/* ticks */
+#define CICLOS 5
+#define TRABAJO 20000000
+
+void trabajar(int n){
+	volatile int i;
+	for (i=0; i<n*TRABAJO; i++);
+}
+
+int main(){
+	int temp, i, inicio, vencidos;
+
+	printf("prueba_temporizador comienza\n");
+
+	inicio=obtener_ticks();
+	dormir_ms(250);
+	printf("dormir_ms(250): %d ticks\n", obtener_ticks()-inicio);
+
+	if (dormir_ms(-1)!=-1)
+		printf("dormir_ms con tiempo negativo. NO DEBE APARECER\n");
+
+	inicio=obtener_ticks();
+	for (i=0; i<CICLOS; i++){
+		trabajar(i%2);
+		dormir_ticks(PERIODO);
+		printf("dormir_ticks: despierta en +%d\n", obtener_ticks()-inicio);
+	}
+
+	if ((temp=crear_temporizador(PERIODO))<0)
+		printf("error creando temporizador. NO DEBE APARECER\n");
+	inicio=obtener_ticks();
+	for (i=0; i<CICLOS; i++){
+		trabajar(i%2);
+		vencidos=esperar_temporizador(temp);
+		printf("temporizador: despierta en +%d (%d vencimientos)\n",
+			obtener_ticks()-inicio, vencidos);
+	}
+
+	/* llegar tarde cuenta todos los periodos perdidos */
+	dormir_ticks(3*PERIODO);
+	if (esperar_temporizador(temp)<3)
+		printf("vencimientos perdidos. NO DEBE APARECER\n");
+
+	if (destruir_temporizador(temp)<0 || esperar_temporizador(temp)!=-1)
+		printf("error destruyendo temporizador. NO DEBE APARECER\n");
+
+	inicio=obtener_ticks();
+	dormir_hasta(inicio+20);
+	printf("dormir_hasta(+20): %d ticks\n", obtener_ticks()-inicio);
+
+	printf("prueba_temporizador termina\n");
+	return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * usuario/prueba_traza.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la traza de eventos del
+ * kernel. Activa todas las categorias, duerme y comprueba que la traza
+ * recoge sus llamadas, su bloqueo y despertar y los cambios de contexto.
+ */
+
+#include "servicios.h"
+
+struct evento_traza eventos[TAM_TRAZA];
+struct estado_traza estado;
+
+int main(){
+	int i, num, yo, anterior;
+	int entradas=0, salidas=0, bloqueos=0, despertares=0, cambios=0, relojes=0;
+	struct evento_traza *e;
+
+	printf("prueba_traza comienza\n");
+	yo=obtener_id_pr();
+
+	anterior=fijar_mascara_traza(TRAZA_TODAS);
+	dormir_ticks(2);
+	obtener_id_pr();
+	fijar_mascara_traza(anterior);
+
+	num=leer_traza(eventos, TAM_TRAZA, &estado);
+	if (num<=0 || estado.eventos<num)
+		printf("error leyendo la traza. NO DEBE APARECER\n");
+
+	for (i=0; i<num; i++){
+		e=&eventos[i];
+		if (i>0 && e->ciclos<eventos[i-1].ciclos)
+			printf("eventos desordenados. NO DEBE APARECER\n");
+		if (e->proceso==yo && e->tipo==TRAZA_ENTRADA_LLAMADA)
+			entradas++;
+		if (e->proceso==yo && e->tipo==TRAZA_SALIDA_LLAMADA)
+			salidas++;
+		if (e->proceso==yo && e->tipo==TRAZA_BLOQUEO && e->dato1==COLA_DORMIR)
+			bloqueos++;
+		if (e->tipo==TRAZA_DESPERTAR && e->dato1==yo)
+			despertares++;
+		if (e->tipo==TRAZA_CAMBIO_CONTEXTO && (e->dato1==yo || e->dato2==yo))
+			cambios++;
+		if (e->tipo==TRAZA_INTERRUPCION)
+			relojes++;
+	}
+	printf("%d eventos: %d entradas, %d salidas, %d bloqueos, %d despertares, %d cambios, %d interrupciones\n",
+		num, entradas, salidas, bloqueos, despertares, cambios, relojes);
+
+	/* dormir_ticks y obtener_id_pr completas, la salida del primer
+	   fijar_mascara_traza y la entrada del segundo */
+	if (entradas!=3 || salidas!=3)
+		printf("llamadas mal trazadas. NO DEBE APARECER\n");
+	if (bloqueos!=1 || despertares!=1 || cambios<2 || relojes<2)
+		printf("faltan eventos de la espera. NO DEBE APARECER\n");
+
+	/* con la mascara a 0 no se anota nada */
+	fijar_mascara_traza(0);
+	i=estado.eventos;
+	obtener_id_pr();
+	leer_traza(0, 0, &estado);
+	if (estado.eventos!=i)
+		printf("se anotan eventos con la traza desactivada. NO DEBE APARECER\n");
+
+	printf("prueba_traza termina\n");
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * usuario/prueba_trylock.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las llamadas trylock
+ * y lock_timeout, tambien sobre un mutex competitivo que se libera y se
+ * vuelve a tomar mientras el otro proceso espera
+ */
+
+#include "servicios.h"
+
+#define VUELTAS_COMPETITIVO 60	/* ticks que se retiene mtc, mas que el plazo de esperador */
+
+int main(){
+	int desc, desc_comp, i;
+
+	printf("prueba_trylock comienza\n");
+
+	if ((desc=crear_mutex("mt", NO_RECURSIVO))<0)
+		printf("error creando mt. NO DEBE APARECER\n");
+
+	/* trylock sobre un mutex libre -> correcto */
+	if (trylock(desc)<0)
+		printf("error en trylock de mutex libre. NO DEBE APARECER\n");
+
+	if ((desc_comp=crear_mutex("mtc", NO_RECURSIVO))<0)
+		printf("error creando mtc. NO DEBE APARECER\n");
+	politica_mutex(desc_comp, COMPETITIVO);
+	lock(desc_comp);
+
+	if (crear_proceso("esperador")<0)
+		printf("Error creando esperador\n");
+
+	printf("prueba_trylock duerme 2 segs. con el mutex bloqueado: vencera la primera espera de esperador\n");
+	dormir(2);
+
+	/* Debe despertar a esperador, que sigue dentro de su segundo plazo */
+	if (unlock(desc)<0)
+		printf("error en unlock de mutex. NO DEBE APARECER\n");
+
+	/* Cada unlock despierta a esperador, pero se vuelve a tomar mtc antes
+	   de que se ejecute: debe seguir esperando solo lo que le queda */
+	for (i=0; i<VUELTAS_COMPETITIVO; i++){
+		unlock(desc_comp);
+		lock(desc_comp);
+		dormir_ticks(1);
+	}
+	unlock(desc_comp);
+
+	printf("prueba_trylock termina\n");
+	return 0;
+}
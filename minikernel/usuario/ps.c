@@ -0,0 +1,71 @@
+/*
+ * usuario/ps.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra una instantanea del sistema: procesos
+ * con su estado y la cola en la que esperan, longitud de las colas del
+ * kernel y mutex en uso con su propietario y procesos bloqueados.
+ */
+
+#include "servicios.h"
+
+#define MAX_PROCESOS 64
+#define MAX_MUTEX 256
+
+static char *nombre_estado(int estado){
+	switch (estado){
+	case 1: return "LISTO";
+	case 2: return "EJECUCION";
+	case 3: return "BLOQUEADO";
+	case 4: return "ZOMBI";
+	}
+	return "TERMINADO";
+}
+
+static char *nombre_cola[]={ "listos", "dormir", "mutex_libre", "mutex_lock",
+	"terminal", "plazo", "rt_agotados", "aparcados", "otra" };
+
+struct instantanea inst;
+struct instantanea_proceso procesos[MAX_PROCESOS];
+struct instantanea_mutex mutex[MAX_MUTEX];
+
+int main(){
+	int i;
+	struct instantanea_proceso *p;
+	struct instantanea_mutex *m;
+
+	if (obtener_instantanea(&inst, procesos, MAX_PROCESOS, mutex, MAX_MUTEX)<0){
+		printf("ps: error obteniendo la instantanea\n");
+		return 1;
+	}
+
+	printf("ps: tick %d, proceso actual %d\n", inst.ticks, inst.proceso_actual);
+	printf("  ID LIDER GRUPO RT ESTADO     COLA         PLAZO MUTEX\n");
+	for (i=0; i<inst.num_procesos; i++){
+		p=&procesos[i];
+		printf("%4d %5d %5d %2d %-10s %-12s %5d %5d\n", p->id, p->lider,
+			p->grupo, p->tiempo_real,
+			p->id==inst.proceso_actual ? "EJECUCION" : nombre_estado(p->estado),
+			p->cola>=0 ? nombre_cola[p->cola] : "-",
+			p->ticks_restantes, p->mutex_esperado);
+	}
+
+	printf("colas:");
+	for (i=0; i<NUM_COLAS_SISTEMA; i++)
+		printf(" %s=%d", nombre_cola[i], inst.longitud_colas[i]);
+	printf("\n");
+
+	printf("  ID NOMBRE   TIPO    POLITICA PROPIETARIO LOCKS BLOQUEADOS APERTURAS\n");
+	for (i=0; i<inst.num_mutex; i++){
+		m=&mutex[i];
+		printf("%4d %-8.8s %-7s %-8s %11d %5d %10d %9d\n", m->id, m->nombre,
+			m->tipo==RECURSIVO ? "rec" : "no_rec",
+			m->politica==FIFO ? "fifo" : "compet",
+			m->propietario, m->num_locks, m->bloqueados, m->aperturas);
+	}
+	return 0;
+}
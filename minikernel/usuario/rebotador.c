@@ -0,0 +1,38 @@
+/*
+ * usuario/rebotador.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de ceder_cpu: devuelve
+ * el turno a prueba_ceder
+ */
+
+#include "servicios.h"
+
+#define RONDAS 20
+
+struct turnos {
+	int turno;
+	int ceder;
+};
+
+int main(){
+	struct turnos *t;
+	int i;
+
+	if ((t=abrir_memoria_compartida("turnos"))==0)
+		printf("error abriendo turnos. NO DEBE APARECER\n");
+
+	for (i=0; i<2*RONDAS; i++){
+		while (t->turno!=1)
+			if (t->ceder)
+				ceder_cpu();
+		t->turno=0;
+	}
+
+	printf("rebotador termina\n");
+	return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * usuario/sumador.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de la memoria
+ * compartida: incrementa el contador del segmento de prueba_memcomp
+ */
+
+#include "servicios.h"
+
+#define NUM_SUMAS 1000
+
+int main(){
+	int *contador, mut, i;
+
+	printf("sumador (%d) comienza\n", obtener_id_pr());
+
+	if ((contador=abrir_memoria_compartida("shm"))==0)
+		printf("error abriendo shm. NO DEBE APARECER\n");
+
+	if ((mut=abrir_mutex("msum"))<0)
+		printf("error abriendo msum. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_SUMAS; i++){
+		lock(mut);
+		(*contador)++;
+		unlock(mut);
+	}
+
+	/* el segmento se cierra implicitamente al terminar */
+	printf("sumador (%d) termina\n", obtener_id_pr());
+	return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * usuario/traza.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que exporta la traza del kernel en formato JSON de
+ * Chrome (chrome://tracing o Perfetto). El procesador aparece como una
+ * linea con un tramo por cada proceso que ejecuta; cada proceso tiene otra
+ * linea con sus llamadas al sistema, bloqueos y despertares.
+ *
+ * Uso: se arranca con la traza activa (MINIKERNEL_TRAZA=0xf ./boot ...),
+ * se ejecuta la carga y despues este programa. Conviene compilar el kernel
+ * con DEPURACION=0 para que la salida solo contenga el JSON.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+/* indexado por los numeros de llamsis.h: un servicio nuevo sin nombre no compila */
+static char *nombre_servicio[]={
+	[CREAR_PROCESO]="crear_proceso",
+	[TERMINAR_PROCESO]="terminar_proceso",
+	[ESCRIBIR]="escribir",
+	[OBTENER_ID]="obtener_id_pr",
+	[DORMIR]="dormir",
+	[CREAR_MUTEX]="crear_mutex",
+	[ABRIR_MUTEX]="abrir_mutex",
+	[LOCK_MUTEX]="lock",
+	[UNLOCK_MUTEX]="unlock",
+	[CERRAR_MUTEX]="cerrar_mutex",
+	[LEER_CARACTER]="leer_caracter",
+	[POLITICA_MUTEX]="politica_mutex",
+	[TRYLOCK_MUTEX]="trylock",
+	[LOCK_TIMEOUT_MUTEX]="lock_timeout",
+	[RESERVAR_BUFFER]="reservar_buffer",
+	[LIBERAR_BUFFER]="liberar_buffer",
+	[CREAR_COLA]="crear_cola",
+	[ENVIAR]="enviar",
+	[RECIBIR]="recibir",
+	[CREAR_MEMORIA_COMPARTIDA]="crear_memoria_compartida",
+	[ABRIR_MEMORIA_COMPARTIDA]="abrir_memoria_compartida",
+	[CERRAR_MEMORIA_COMPARTIDA]="cerrar_memoria_compartida",
+	[CREAR_HILO]="crear_hilo",
+	[DATOS_HILO]="datos_hilo",
+	[LEER_CARACTER_NB]="leer_caracter_nb",
+	[OBTENER_TICKS]="obtener_ticks",
+	[ESPERAR_EVENTO]="esperar_evento",
+	[CEDER_CPU]="ceder_cpu",
+	[DORMIR_TICKS]="dormir_ticks",
+	[DORMIR_MS]="dormir_ms",
+	[DORMIR_HASTA]="dormir_hasta",
+	[CREAR_TEMPORIZADOR]="crear_temporizador",
+	[ESPERAR_TEMPORIZADOR]="esperar_temporizador",
+	[DESTRUIR_TEMPORIZADOR]="destruir_temporizador",
+	[FIJAR_TIEMPO_REAL]="fijar_tiempo_real",
+	[ESPERAR_PERIODO]="esperar_periodo",
+	[PLAZOS_PERDIDOS]="plazos_perdidos",
+	[FIJAR_GRUPO]="fijar_grupo",
+	[FIJAR_CUOTA]="fijar_cuota",
+	[OBTENER_ESTADISTICAS]="obtener_estadisticas",
+	[OBTENER_INSTANTANEA]="obtener_instantanea",
+	[OBTENER_PERFIL_MUTEX]="obtener_perfil_mutex",
+	[FIJAR_MASCARA_TRAZA]="fijar_mascara_traza",
+	[LEER_TRAZA]="leer_traza",
+	[OBTENER_PERFIL_LLAMADA]="obtener_perfil_llamada",
+	[FIJAR_MUESTREO]="fijar_muestreo",
+	[LEER_MUESTRAS]="leer_muestras",
+	[RESOLVER_DIRECCION]="resolver_direccion",
+	[OBTENER_LATENCIAS]="obtener_latencias",
+	[OBTENER_TIEMPO]="obtener_tiempo",
+	[OBTENER_PAGINA_TIEMPO]="obtener_pagina_tiempo",
+	[OBTENER_ESTADISTICAS_TERMINAL]="obtener_estadisticas_terminal" };
+#define NUM_NOMBRES (sizeof(nombre_servicio)/sizeof(nombre_servicio[0]))
+typedef char faltan_nombres_de_servicio[(NUM_NOMBRES==NSERVICIOS) ? 1 : -1];
+
+static char *nombre_cola[]={ "listos", "dormir", "mutex_libre", "mutex_lock",
+	"terminal", "plazo", "rt_agotados", "aparcados", "otra" };
+
+struct evento_traza eventos[TAM_TRAZA];
+struct estado_traza estado;
+
+static unsigned long long inicio;
+static int primero=1;
+
+/* microsegundos desde el arranque */
+static unsigned long long us(unsigned long long ciclos){
+	return (ciclos-estado.ciclos_inicio)*1000/estado.ciclos_por_ms;
+}
+
+static void separador(){
+	printf(primero ? "\n" : ",\n");
+	primero=0;
+}
+
+static char *servicio(int n){
+	return (n>=0 && n<NUM_NOMBRES && nombre_servicio[n]!=0) ? nombre_servicio[n] : "desconocido";
+}
+
+int main(){
+	int i, num, en_cpu=-1;
+	struct evento_traza *e;
+
+	fijar_mascara_traza(0);	/* la lectura no debe aparecer en la traza */
+	num=leer_traza(eventos, TAM_TRAZA, &estado);
+	if (num<0 || estado.ciclos_por_ms==0){
+		printf("traza: no se puede leer la traza\n");
+		return 1;
+	}
+
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	separador();
+	printf("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"procesador\"}}");
+	separador();
+	printf("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"procesos\"}}");
+
+	for (i=0; i<num; i++){
+		e=&eventos[i];
+		switch (e->tipo){
+		case TRAZA_CAMBIO_CONTEXTO:
+			/* cierra el tramo del proceso que deja el procesador */
+			if (en_cpu>=0){
+				separador();
+				printf("{\"name\": \"proceso %d\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, \"ts\": %llu, \"dur\": %llu}",
+					en_cpu, us(inicio), us(e->ciclos)-us(inicio));
+			}
+			en_cpu=e->dato2;
+			inicio=e->ciclos;
+			break;
+		case TRAZA_ENTRADA_LLAMADA:
+			separador();
+			printf("{\"name\": \"%s\", \"cat\": \"llamadas\", \"ph\": \"B\", \"pid\": 1, \"tid\": %d, \"ts\": %llu}",
+				servicio(e->dato1), e->proceso, us(e->ciclos));
+			break;
+		case TRAZA_SALIDA_LLAMADA:
+			separador();
+			printf("{\"name\": \"%s\", \"cat\": \"llamadas\", \"ph\": \"E\", \"pid\": 1, \"tid\": %d, \"ts\": %llu, \"args\": {\"resultado\": %d}}",
+				servicio(e->dato1), e->proceso, us(e->ciclos), e->dato2);
+			break;
+		case TRAZA_BLOQUEO:
+			separador();
+			printf("{\"name\": \"bloqueo en %s\", \"cat\": \"esperas\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": %d, \"ts\": %llu}",
+				(e->dato1>=0 && e->dato1<=COLA_OTRA) ? nombre_cola[e->dato1] : "?", e->proceso, us(e->ciclos));
+			break;
+		case TRAZA_DESPERTAR:
+			separador();
+			printf("{\"name\": \"despertar\", \"cat\": \"esperas\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": %d, \"ts\": %llu, \"args\": {\"por\": %d}}",
+				e->dato1, us(e->ciclos), e->proceso);
+			break;
+		case TRAZA_INTERRUPCION:
+			separador();
+			printf("{\"name\": \"interrupcion %d\", \"cat\": \"interrupciones\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 0, \"tid\": 0, \"ts\": %llu}",
+				e->dato1, us(e->ciclos));
+			break;
+		}
+	}
+	printf("\n], \"otherData\": {\"eventos\": %u, \"perdidos\": %u}}\n",
+		num, estado.eventos-num);
+	return 0;
+}